@@ -9,10 +9,15 @@
 #include "JC3248W535EN_Touch_LCD.h" 
 #include "esp_heap_caps.h"
 #include <Ticker.h>
-#include <vector>
 #include <algorithm>
+#include <new>
+#include "caro_smp.h"
+#include "caro_book.h"
+#include "caro_mcts.h"
+#include "caro_bench.h"
 
 // Font declarations
+extern const lv_font_t lv_font_montserrat_12;
 extern const lv_font_t lv_font_montserrat_16;
 extern const lv_font_t lv_font_montserrat_22; 
 
@@ -39,19 +44,17 @@ lv_color_t* buf = nullptr;
 JC3248W535EN tft;
 
 /*######################### GAME CỜ CARO ###############*/
-#define BOARD_SIZE 10 
-#define WIN_COUNT 5   
-
 // --- Game Modes & AI Levels ---
 enum GameMode { MODE_PVP, MODE_PVE };
-enum AILevel { AI_EASY = 1, AI_MEDIUM = 2, AI_HARD = 3 };
+enum AILevel { AI_EASY = 1, AI_MEDIUM = 2, AI_HARD = 3, AI_MCTS = 4 };
 
 static GameMode current_mode = MODE_PVP;
 static AILevel current_ai_level = AI_EASY;
-static bool is_ai_thinking = false;
+static bool is_ai_thinking = false; // An AI move of the current game is pending
 
 // --- Game State ---
 static char board[BOARD_SIZE][BOARD_SIZE]; 
+static RuleSet current_rules = RULES_FREESTYLE; // Chosen in the menu, kept across games
 static char currentPlayer; // 'X' (Người/Máy 1), 'O' (Người/Máy 2)
 static bool game_over;
 static bool game_running = false; 
@@ -93,18 +96,167 @@ SemaphoreHandle_t lvgl_mutex;
 #define LVGL_LOCK()   xSemaphoreTake(lvgl_mutex, portMAX_DELAY)
 #define LVGL_UNLOCK() xSemaphoreGive(lvgl_mutex)
 
-// --- AI Structs ---
-struct Point {
-    int r, c;
+// --- AI ---
+// Optional AI game clock: the per-move budget then comes from the clock instead of the level
+#define AI_CLOCK_BASE_MS 0    // 0 = off
+#define AI_CLOCK_INC_MS  2000 // Added after every AI move
+
+// Lazy SMP: the AI task searches on core 1, a helper thread on core 0 next to the LVGL task
+#define AI_SEARCH_THREADS 2 // 1 = single-threaded, up to SMP_MAX_THREADS
+#define AI_HELPER_CORE    0
+
+// 1 = print the fixed benchmark (caro_bench.h) as CSV on the serial port before the UI starts
+#define AI_BENCH_AT_BOOT 0
+
+static TransTable tt;    // Allocated in PSRAM by setup()
+static bool tt_ok = false;
+static GameClock ai_clock;
+static OpeningBook ai_book; // Mapped from the flash partition by setup(), Hard under freestyle only
+static NnueNet ai_net;      // Copied from the same partition by setup(), evaluates for Hard
+static bool ai_net_ok = false;
+
+// Everything compiled for one rule set. Only the engine of current_rules exists:
+// they share engine_storage and select_rules() rebuilds it from the menu.
+template <class Rules>
+struct RuleEngine {
+    BasicPosition<Rules> pos;         // Bit-planes and line scores mirroring board[][]
+    BasicParallelSearch<Rules> search;
+    BasicMcts<Rules> mcts;            // Node arena in PSRAM
+    BasicPosition<Rules> ponder_pos;  // Game position after the expected reply
+    BasicPosition<Rules> job_pos;     // What the AI worker searches: pos, copied under the LVGL lock
+    BasicPosition<Rules> hint_pos;    // job_pos with the side asking for a hint as O
+
+    bool forbidden(int sq) const { return rule_forbidden<Rules>(pos.stones[PLAYER_X], pos.stones[PLAYER_O], sq); }
+    Bitboard five_starts(int player, int dir) const {
+        return rule_five_starts<Rules>(pos.stones[player], pos.stones[player ^ 1], dir, player);
+    }
 };
 
+static constexpr size_t ENGINE_BYTES = std::max({ sizeof(RuleEngine<FreestyleRules>), sizeof(RuleEngine<ExactFiveRules>),
+                                                  sizeof(RuleEngine<CaroRules>), sizeof(RuleEngine<RenjuRules>) });
+alignas(RuleEngine<FreestyleRules>) static uint8_t engine_storage[ENGINE_BYTES];
+
+// Calls f with a default-constructed rules struct of current_rules
+template <class F>
+static void with_rules(F&& f) {
+    switch (current_rules) {
+        case RULES_EXACT_FIVE: f(ExactFiveRules()); break;
+        case RULES_CARO:       f(CaroRules()); break;
+        case RULES_RENJU:      f(RenjuRules()); break;
+        default:               f(FreestyleRules()); break;
+    }
+}
+
+template <class Rules>
+static RuleEngine<Rules>& engine() { return *std::launder(reinterpret_cast<RuleEngine<Rules>*>(engine_storage)); }
+
+// Calls f with the current engine; once per move or UI event, never inside a search
+template <class F>
+static void with_engine(F&& f) {
+    with_rules([&](auto rules) { f(engine<decltype(rules)>()); });
+}
+
+// --- AI worker ---
+// One long-lived task on core 1 (LVGL runs on core 0) does all engine work, one job at a
+// time: the AI move, and pondering in between. Jobs come in through ai_jobs; moves go back
+// through ai_results, which the LVGL task drains (ai_result_timer_cb), so the worker never
+// draws and never waits for the UI except to copy the position.
+//
+// Every job carries the generation of ai_cancel it was queued under. A new game, the menu or
+// a rule change bumps it: a running search stops within SEARCH_CHECK_NODES nodes, queued jobs
+// are skipped and a move that still arrives is dropped. Background jobs stop as well as soon
+// as any newer job is queued (ai_preempt). The engine itself is guarded by ai_engine_lock,
+// held by the worker for the length of a job. Lock order: the LVGL lock, then the engine, so
+// select_rules() may wait for the engine from the UI.
+#define AI_WORKER_CORE 1
+// Peak use measured on the host (x86-64, painted stack) for the Hard search and MCTS on the
+// benchmark positions: 12.5 KB. Xtensa register windows take more per frame and DEBUG_PRINTF
+// needs its own, hence the margin; the worker reports its high-water mark (DEBUG_PRINTF and
+// the serial command "stats") to check it against on the device.
+#define AI_WORKER_STACK 20480
+#define AI_QUEUE_LENGTH 4
+// How long a rule change waits for the abandoned job to unwind. A cancelled search returns
+// within SEARCH_CHECK_NODES nodes, so this is only reached if the worker is stuck.
+#define AI_RULES_WAIT_MS 500
+
+// After its move the AI keeps searching the position after the reply it expects, for up
+// to AI_PONDER_BUDGET times its move budget, so a correct guess is answered from a warm TT
+// (or at once if enough time was spent). Pondering is single-threaded: the Lazy SMP helper
+// shares core 0 with LVGL at the same priority and never yields, so a long ponder would
+// starve LVGL and the idle task (task watchdog) for as long as the player thinks.
+#define AI_PONDER 1 // 0 = off
+#define AI_PONDER_BUDGET 3
+
+// Hint button: one search from the side to move's point of view scores all its moves
+// (SearchLimits::all_root_scores); the best one is outlined, the others shaded from green
+// down to red as they fall HINT_SCORE_SPAN below it
+#define AI_HINT_HEATMAP 1     // 0 = outline the best move only
+#define AI_HINT_MS      1000
+#define HINT_SCORE_SPAN 10000 // A blocked four
+
+enum AiJobKind : uint8_t { AI_JOB_MOVE, AI_JOB_PONDER, AI_JOB_HINT };
+
+struct AiJob {
+    AiJobKind kind;
+    uint8_t arg;         // AI_JOB_PONDER: the expected move of X; AI_JOB_HINT: the side asking
+    uint32_t generation; // Of ai_cancel
+    uint32_t preempt;    // Of ai_preempt
+};
+
+struct AiResult {
+    uint32_t generation;
+    bool searched; // Easy picks at random
+    SearchResult result;
+};
+
+struct AiHint {
+    uint32_t generation;
+    uint64_t key;        // Of the position asked about: a move played meanwhile voids the hint
+    SearchResult result; // From the side asking's point of view
+    RootScores roots;
+};
+
+static QueueHandle_t ai_jobs;
+static QueueHandle_t ai_results;
+static QueueHandle_t ai_hints; // Holds the latest hint only
+static CancelToken ai_cancel;
+static CancelToken ai_preempt;
+static SemaphoreHandle_t ai_engine_lock;
+static uint32_t ai_stack_free = AI_WORKER_STACK; // Lowest free stack of the worker so far, bytes
+
+// Worker only
+static SearchResult ponder_result;
+static bool ponder_valid = false;
+static AiHint worker_hint; // Too big for the worker's stack next to the search
+
+static bool hint_pending = false; // UI only
+static bool hint_shown = false;
+
+// From the UI (LVGL lock held): drops the pending AI move and any background job
+static void abandon_ai() {
+    ai_cancel.cancel();
+    ai_preempt.cancel();
+    is_ai_thinking = false;
+    hint_pending = false;
+}
+
+// --- Search statistics ---
+// The last AI search, shown in a small overlay on the game screen and printed by the serial command "stats"
+#define AI_STATS_OVERLAY 1 // 0 = serial only
+
+static const char* const SOURCE_NAMES[] = { "search", "VCF", "VCT", "book", "MCTS" };
+static lv_obj_t* stats_label;
+static SearchResult last_ai_result; // Written by the LVGL task
+static bool last_ai_valid = false;
+
 // --- Prototypes ---
 void create_menu_ui();
 void create_game_ui();
 void reset_game();
 void make_move(int r, int c);
-void start_ai_task();
+void request_ai_move();
 static char check_win_and_fill_positions();
+static void show_search_stats();
 
 /*##################### DISP FLUSH ########################*/
 void my_disp_flush (lv_display_t *disp, const lv_area_t *area, uint8_t *pixelmap) {
@@ -170,188 +322,329 @@ void lvglTask(void *pvParameters) {
 // =========================== AI LOGIC ============================
 // =================================================================
 
-// Điểm số đánh giá
-#define SCORE_WIN       1000000
-#define SCORE_OPEN_4    50000   
-#define SCORE_BLOCKED_4 10000   
-#define SCORE_OPEN_3    5000    
-#define SCORE_BLOCKED_3 1000
-#define SCORE_OPEN_2    500
+// Search budget per level: iterative deepening stops at max_depth or when the time is up
+static SearchLimits ai_limits(AILevel level) {
+    if (level == AI_MEDIUM) return {2, 300, 0, 0, QUIESCE_NODE_LIMIT, false};
+    if (level == AI_MCTS) return {0, 1500, 0, 0, 0, false}; // Time only
+    return {10, 1500, 10, 4, QUIESCE_NODE_LIMIT, false};
+}
 
-std::vector<Point> get_neighbor_moves(int range) {
-    std::vector<Point> moves;
-    bool visited[BOARD_SIZE][BOARD_SIZE] = {false};
+// Builds the engine of current_rules in engine_storage
+static void engine_start() {
+    with_rules([](auto rules) {
+        auto* e = new (engine_storage) RuleEngine<decltype(rules)>();
+        e->search.init(tt_ok ? &tt : nullptr);
+        e->search.threads = tt_ok ? AI_SEARCH_THREADS : 1; // Helpers only help through the table
+        e->search.helper_core = AI_HELPER_CORE;
+        if (!e->mcts.init()) DEBUG_PRINTLN("MCTS arena alloc failed, the MCTS level uses the search");
+    });
+}
 
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            if (board[r][c] != ' ') {
-                for (int dr = -range; dr <= range; dr++) {
-                    for (int dc = -range; dc <= range; dc++) {
-                        int nr = r + dr;
-                        int nc = c + dc;
-                        if (nr >= 0 && nr < BOARD_SIZE && nc >= 0 && nc < BOARD_SIZE) {
-                            if (board[nr][nc] == ' ' && !visited[nr][nc]) {
-                                moves.push_back({nr, nc});
-                                visited[nr][nc] = true;
-                            }
-                        }
-                    }
-                }
+// Swaps in the engine of another rule set. Only from the menu, between games. False if the
+// worker did not let go of the engine within AI_RULES_WAIT_MS.
+static bool select_rules(RuleSet rules) {
+    if (rules == current_rules) return true;
+    abandon_ai();
+    if (xSemaphoreTake(ai_engine_lock, pdMS_TO_TICKS(AI_RULES_WAIT_MS)) != pdTRUE) return false;
+    with_engine([](auto& e) {
+        using Engine = std::decay_t<decltype(e)>;
+        e.mcts.release();
+        e.~Engine();
+    });
+    tt.clear(); // Scores stored under the old rules would be wrong
+    ponder_valid = false;
+    current_rules = rules;
+    engine_start();
+    xSemaphoreGive(ai_engine_lock);
+    return true;
+}
+
+static void run_move_job(const CancelCheck& job) {
+    AiResult out = { job.generation, false, { {-1, -1}, 0, SOURCE_SEARCH, {} } };
+    SearchResult& res = out.result;
+
+    with_engine([&](auto& e) {
+        bool ponder_hit = ponder_valid && e.job_pos.key == e.ponder_pos.key;
+        ponder_valid = false;
+        e.search.cancel = job;
+        e.mcts.cancel = job;
+        if (current_ai_level == AI_EASY) {
+            e.search.workers[0].pos = e.job_pos;
+            MoveList moves;
+            e.search.workers[0].gen_moves(moves, 1, PLAYER_O);
+            if (moves.count > 0) {
+                int sq = moves.sq[rand() % moves.count];
+                res.move = {bb_row(sq), bb_col(sq)};
             }
+            return;
         }
-    }
-    
-    if (moves.empty()) {
-        moves.push_back({BOARD_SIZE/2, BOARD_SIZE/2});
-    }
-    return moves;
+
+        // Without its arena the MCTS level plays as Hard: its own limits leave the search no depth
+        AILevel level = current_ai_level;
+        if (level == AI_MCTS && !e.mcts.ready()) {
+            DEBUG_PRINTLN("MCTS unavailable (no arena), searching as Hard");
+            level = AI_HARD;
+        }
+        SearchLimits limits = ai_limits(level);
+        if (AI_CLOCK_BASE_MS > 0) limits.budget_ms = ai_clock.budget_ms(e.job_pos);
+
+        bool use_book = level == AI_HARD && current_rules == RULES_FREESTYLE; // The book is freestyle analysis
+        int book_sq = use_book ? ai_book.probe(e.job_pos, PLAYER_O) : -1;
+        uint32_t pondered_ms = ponder_hit ? ponder_result.stats.elapsed_us / 1000 : 0;
+        if (book_sq >= 0) {
+            res = { {bb_row(book_sq), bb_col(book_sq)}, 0, SOURCE_BOOK, {} };
+        } else if (level == AI_MCTS) {
+            res = e.mcts.think(e.job_pos, limits);
+        } else if (ponder_hit && (ponder_result.source != SOURCE_SEARCH || ponder_result.stats.depth >= limits.max_depth ||
+                           (limits.budget_ms && pondered_ms >= limits.budget_ms))) {
+            res = ponder_result; // Already searched for as long as this move may take
+            res.stats.elapsed_us = 0;
+        } else {
+            if (ponder_hit && limits.budget_ms) limits.budget_ms = std::max(limits.budget_ms - pondered_ms, (uint32_t)50);
+            res = e.search.think(e.job_pos, limits);
+        }
+        out.searched = true;
+
+        const SearchStats& s = res.stats;
+        if (AI_CLOCK_BASE_MS > 0) ai_clock.on_move_done(s.elapsed_us / 1000);
+        DEBUG_PRINTF("AI (%s%s, %s): depth %d, %u nodes (%u quiescence, %u cut by its limit), %u/%u ms, %d threads, TT hits %u/%u\n",
+                     SOURCE_NAMES[res.source], ponder_hit ? ", ponder hit" : "", RULE_NAMES[current_rules], s.depth, s.nodes,
+                     s.qnodes, s.qlimit_hits, s.elapsed_us / 1000, limits.budget_ms, e.search.threads, s.tt_hits, s.tt_probes);
+    });
+
+    if (!job.cancelled()) xQueueSend(ai_results, &out, portMAX_DELAY);
 }
 
-int evaluate_line(int count, int blocked, char player) {
-    if (count >= 5) return SCORE_WIN;
-    
-    int score = 0;
-    if (count == 4) score = (blocked == 0) ? SCORE_OPEN_4 : (blocked == 1 ? SCORE_BLOCKED_4 : 0);
-    else if (count == 3) score = (blocked == 0) ? SCORE_OPEN_3 : (blocked == 1 ? SCORE_BLOCKED_3 : 0);
-    else if (count == 2) score = (blocked == 0) ? SCORE_OPEN_2 : 0;
+// Searches the position after the expected reply, on this core only, until preempted,
+// max_depth or AI_PONDER_BUDGET move budgets
+static void run_ponder_job(const CancelCheck& job, int reply) {
+    with_engine([&](auto& e) {
+        e.ponder_pos = e.job_pos;
+        e.ponder_pos.make_move(reply, PLAYER_X);
+        SearchLimits limits = ai_limits(current_ai_level);
+        limits.budget_ms *= AI_PONDER_BUDGET;
+        int threads = e.search.threads;
+        e.search.threads = 1;
+        e.search.cancel = job;
+        ponder_result = e.search.think(e.ponder_pos, limits);
+        e.search.threads = threads;
+        ponder_valid = ponder_result.move.r != -1;
+    });
+}
 
-    return (player == 'O') ? score : -score; 
+// Scores every move of the side asking with one search. The search plays O, so the colours
+// are swapped when X asks.
+static void run_hint_job(const CancelCheck& job, int player) {
+    AiHint& out = worker_hint;
+    with_engine([&](auto& e) {
+        e.hint_pos.clear();
+        e.hint_pos.set_net(e.job_pos.net); // Same evaluation as the game's AI
+        for (int p = 0; p < 2; p++) {
+            Bitboard s = e.job_pos.stones[p];
+            while (bb_any(s)) e.hint_pos.make_move(bb_pop_lsb(s), (p == player) ? PLAYER_O : PLAYER_X);
+        }
+        e.search.cancel = job;
+        out.result = e.search.think(e.hint_pos, { 10, AI_HINT_MS, 10, 4, QUIESCE_NODE_LIMIT, true });
+        out.roots = e.search.workers[0].root_scores;
+        out.key = e.job_pos.key;
+    });
+    out.generation = ai_cancel.current();
+    if (!job.cancelled()) xQueueOverwrite(ai_hints, &out);
 }
 
-int evaluate_board_gomoku() {
-    int total_score = 0;
-    int dr[] = {0, 1, 1, 1};
-    int dc[] = {1, 0, 1, -1};
+static void ai_worker(void* parameter) {
+    AiJob job;
+    for (;;) {
+        xQueueReceive(ai_jobs, &job, portMAX_DELAY);
+        const CancelCheck check = job.kind == AI_JOB_MOVE ? CancelCheck{ &ai_cancel, job.generation }
+                                                          : CancelCheck{ &ai_preempt, job.preempt };
+        // The UI changes pos and queues jobs under the LVGL lock: a job still current here
+        // sees the position it was queued for. Under the LVGL lock the engine is free: the
+        // UI only takes it inside select_rules(), which holds the LVGL lock throughout.
+        LVGL_LOCK();
+        xSemaphoreTake(ai_engine_lock, portMAX_DELAY);
+        bool stale = check.cancelled();
+        if (!stale) with_engine([](auto& e) { e.job_pos = e.pos; });
+        LVGL_UNLOCK();
+
+        if (!stale) {
+            if (job.kind == AI_JOB_MOVE) run_move_job(check);
+            else if (job.kind == AI_JOB_PONDER) run_ponder_job(check, job.arg);
+            else run_hint_job(check, job.arg);
 
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            if (board[r][c] == ' ') continue;
-            
-            char p = board[r][c];
-            
-            for (int dir = 0; dir < 4; dir++) {
-                int prev_r = r - dr[dir];
-                int prev_c = c - dc[dir];
-                if (prev_r >= 0 && prev_r < BOARD_SIZE && prev_c >= 0 && prev_c < BOARD_SIZE && board[prev_r][prev_c] == p) {
-                    continue;
-                }
-
-                int count = 0;
-                int blocked = 0;
-                
-                if (prev_r < 0 || prev_r >= BOARD_SIZE || prev_c < 0 || prev_c >= BOARD_SIZE || board[prev_r][prev_c] != ' ') {
-                    blocked++;
-                }
-
-                int cur_r = r;
-                int cur_c = c;
-                while (cur_r >= 0 && cur_r < BOARD_SIZE && cur_c >= 0 && cur_c < BOARD_SIZE && board[cur_r][cur_c] == p) {
-                    count++;
-                    cur_r += dr[dir];
-                    cur_c += dc[dir];
-                }
-
-                if (cur_r < 0 || cur_r >= BOARD_SIZE || cur_c < 0 || cur_c >= BOARD_SIZE || board[cur_r][cur_c] != ' ') {
-                    blocked++;
-                }
-                
-                total_score += evaluate_line(count, blocked, p);
+            uint32_t free_bytes = uxTaskGetStackHighWaterMark(NULL);
+            if (free_bytes < ai_stack_free) {
+                ai_stack_free = free_bytes;
+                DEBUG_PRINTF("AI worker: %u of %u stack bytes never used\n", free_bytes, AI_WORKER_STACK);
             }
         }
-    }
-    return total_score;
-}
-
-int minimax(int depth, int alpha, int beta, bool isMaximizing) {
-    int score = evaluate_board_gomoku();
-    if (abs(score) > SCORE_WIN / 2) return score; 
-    if (depth == 0) return score;
-
-    std::vector<Point> moves = get_neighbor_moves(1); 
-    if (moves.empty()) return 0;
-
-    if (isMaximizing) { // AI ('O')
-        int maxEval = -2000000000;
-        for (auto m : moves) {
-            board[m.r][m.c] = 'O';
-            int eval = minimax(depth - 1, alpha, beta, false);
-            board[m.r][m.c] = ' '; // Undo
-            maxEval = std::max(maxEval, eval);
-            alpha = std::max(alpha, eval);
-            if (beta <= alpha) break;
-        }
-        return maxEval;
-    } else { // Human ('X')
-        int minEval = 2000000000;
-        for (auto m : moves) {
-            board[m.r][m.c] = 'X';
-            int eval = minimax(depth - 1, alpha, beta, true);
-            board[m.r][m.c] = ' '; // Undo
-            minEval = std::min(minEval, eval);
-            beta = std::min(beta, eval);
-            if (beta <= alpha) break;
-        }
-        return minEval;
+        xSemaphoreGive(ai_engine_lock);
     }
 }
 
-void ai_play_task(void *parameter) {
-    if (!game_running) {
-        is_ai_thinking = false;
-        vTaskDelete(NULL);
-        return;
-    }
+// From the UI (LVGL lock held)
+static void queue_ai_job(AiJobKind kind, int arg = 0) {
+    ai_preempt.cancel(); // Stops pondering or a hint: any new job is more urgent
+    AiJob job = { kind, (uint8_t)arg, ai_cancel.current(), ai_preempt.current() };
+    if (xQueueSend(ai_jobs, &job, 0) != pdTRUE) DEBUG_PRINTLN("AI job queue full, job dropped");
+}
 
-    LVGL_LOCK();
-    lv_label_set_text(status_label, "AI Thinking...");
-    LVGL_UNLOCK();
+// Queues a search of the position after the reply the AI expects, if worth it
+static void request_ponder() {
+    // MCTS keeps its subtree between moves instead
+    if (!AI_PONDER || current_ai_level == AI_EASY || current_ai_level == AI_MCTS || game_over || !game_running) return;
+
+    with_engine([](auto& e) {
+        // Expected reply: the best move stored for X in the position after our move
+        TTEntry te;
+        if (!tt.probe(e.pos.key ^ ZOBRIST.side, te) || te.move == TT_NO_MOVE) return;
+        if (!bb_test(e.pos.empty(), te.move) || e.forbidden(te.move)) return;
+
+        auto after = e.pos;
+        after.make_move(te.move, PLAYER_X);
+        if (abs(after.score) > SCORE_WIN / 2) return; // The reply would end the game
+        queue_ai_job(AI_JOB_PONDER, te.move);
+    });
+}
 
-    Point bestMove = {-1, -1};
+// Hint button: the side to move asks the AI to score its moves
+static void request_hint() {
+    if (!game_running || game_over || is_ai_thinking || hint_pending) return;
+    if (current_mode == MODE_PVE && currentPlayer == 'O') return;
+    if (current_rules == RULES_RENJU) return; // The search only plays O, and renju treats the colours differently
+    hint_pending = true;
+    lv_label_set_text(status_label, "Hint...");
+    queue_ai_job(AI_JOB_HINT, player_index(currentPlayer));
+}
 
-    if (current_ai_level == AI_EASY) {
-        std::vector<Point> moves = get_neighbor_moves(1);
-        if (!moves.empty()) {
-            int idx = rand() % moves.size();
-            bestMove = moves[idx];
+// Removes the hint colours; before a stone's own style goes on, which they would cover
+static void clear_hint() {
+    if (!hint_shown) return;
+    hint_shown = false;
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            if (!cell_panels[r][c]) continue;
+            lv_obj_remove_local_style_prop(cell_panels[r][c], LV_STYLE_BG_COLOR, 0);
+            lv_obj_remove_local_style_prop(cell_panels[r][c], LV_STYLE_BG_OPA, 0);
+            lv_obj_remove_local_style_prop(cell_panels[r][c], LV_STYLE_BORDER_COLOR, 0);
+            lv_obj_remove_local_style_prop(cell_panels[r][c], LV_STYLE_BORDER_WIDTH, 0);
         }
-    } else {
-        int depth = (current_ai_level == AI_MEDIUM) ? 1 : 2; 
-        std::vector<Point> moves = get_neighbor_moves(1);
-        int bestVal = -2000000000;
+    }
+}
 
-        for (auto m : moves) {
-            if (!game_running) break;
+static void show_hint(const AiHint& h) {
+    uint64_t key = 0;
+    with_engine([&](auto& e) { key = e.pos.key; });
+    if (!hint_pending || h.generation != ai_cancel.current() || h.key != key || game_over) return;
+    hint_pending = false;
+
+    char buf[20];
+    sprintf(buf, "%c Turn", currentPlayer);
+    lv_label_set_text(status_label, buf);
+    if (h.result.move.r == -1) return;
+
+    clear_hint();
+    hint_shown = true;
+    if (AI_HINT_HEATMAP) {
+        int best = -SEARCH_INF;
+        for (int i = 0; i < h.roots.count; i++) best = std::max(best, h.roots.score[i]);
+        for (int i = 0; i < h.roots.count; i++) {
+            int loss = std::min(best - h.roots.score[i], HINT_SCORE_SPAN);
+            lv_obj_t* cell = cell_panels[bb_row(h.roots.sq[i])][bb_col(h.roots.sq[i])];
+            lv_color_t color = lv_color_mix(lv_palette_main(LV_PALETTE_RED), lv_palette_main(LV_PALETTE_GREEN),
+                                            (uint8_t)(loss * 255 / HINT_SCORE_SPAN));
+            lv_obj_set_style_bg_color(cell, color, 0);
+            lv_obj_set_style_bg_opa(cell, LV_OPA_70, 0);
+        }
+    }
+    lv_obj_t* cell = cell_panels[h.result.move.r][h.result.move.c];
+    lv_obj_set_style_border_color(cell, lv_palette_main(LV_PALETTE_GREEN), 0);
+    lv_obj_set_style_border_width(cell, 4, 0);
+}
 
-            board[m.r][m.c] = 'O'; 
-            int moveVal = minimax(depth - 1, -2000000000, 2000000000, false); 
-            board[m.r][m.c] = ' '; 
+// LVGL timer: plays the AI moves of the current game and shows its hints
+static void ai_result_timer_cb(lv_timer_t* timer) {
+    static AiHint hint; // Too big for the LVGL task's stack
+    if (xQueueReceive(ai_hints, &hint, 0) == pdTRUE) show_hint(hint);
 
-            if (moveVal > bestVal) {
-                bestMove = m;
-                bestVal = moveVal;
-            }
-            vTaskDelay(1); 
+    AiResult out;
+    while (xQueueReceive(ai_results, &out, 0) == pdTRUE) {
+        if (out.generation != ai_cancel.current()) continue; // Searched for an abandoned game
+        is_ai_thinking = false;
+        if (out.searched) {
+            last_ai_result = out.result;
+            last_ai_valid = true;
+            show_search_stats();
+        }
+        if (out.result.move.r != -1) {
+            make_move(out.result.move.r, out.result.move.c);
+            request_ponder();
+        } else {
+            lv_label_set_text(status_label, "Draw!");
         }
     }
+}
 
-    is_ai_thinking = false;
+// Under the LVGL lock
+static void show_search_stats() {
+    if (!AI_STATS_OVERLAY || !stats_label) return;
+    if (!last_ai_valid) {
+        lv_label_set_text(stats_label, "");
+        return;
+    }
+    const SearchStats& s = last_ai_result.stats;
+    uint32_t ms = s.elapsed_us / 1000;
+    uint32_t knps = s.elapsed_us ? (uint32_t)((uint64_t)s.nodes * 1000 / s.elapsed_us) : 0;
+    lv_label_set_text_fmt(stats_label, "%s d%d/%d\n%luk nodes\n%luk/s %lums\nbf %d.%d TT %lu%%",
+                          SOURCE_NAMES[last_ai_result.source], s.depth, s.seldepth, (unsigned long)(s.nodes / 1000),
+                          (unsigned long)knps, (unsigned long)ms, (int)s.branching(), (int)(s.branching() * 10) % 10,
+                          (unsigned long)(s.tt_probes ? (uint64_t)s.tt_hits * 100 / s.tt_probes : 0));
+}
 
-    if (game_running && bestMove.r != -1) {
-        LVGL_LOCK();
-        make_move(bestMove.r, bestMove.c);
-        LVGL_UNLOCK();
-    } else if (bestMove.r == -1) {
-        LVGL_LOCK();
-        lv_label_set_text(status_label, "Draw!");
-        LVGL_UNLOCK();
+// Full statistics of the last AI search on the serial port
+static void print_search_stats() {
+    LVGL_LOCK();
+    SearchResult r = last_ai_result;
+    bool valid = last_ai_valid;
+    LVGL_UNLOCK();
+    Serial.printf("AI worker stack: %lu of %u bytes never used\n", (unsigned long)ai_stack_free, AI_WORKER_STACK);
+    if (!valid) {
+        Serial.println("No AI search yet");
+        return;
     }
+    const SearchStats& s = r.stats;
+    Serial.printf("source %s, move (%d, %d), score %d\n", SOURCE_NAMES[r.source], r.move.r, r.move.c, r.score);
+    Serial.printf("depth %d, seldepth %d, %lu us\n", s.depth, s.seldepth, (unsigned long)s.elapsed_us);
+    Serial.printf("nodes %lu (quiescence %lu, %lu leaves cut by its limit), threat solver %lu\n", (unsigned long)s.nodes,
+                  (unsigned long)s.qnodes, (unsigned long)s.qlimit_hits, (unsigned long)s.threat_nodes);
+    Serial.printf("leaves %lu, evaluations %lu\n", (unsigned long)s.leaves, (unsigned long)s.evals);
+    Serial.printf("cutoffs %lu (%lu on the first move), branching %.2f, effective %.2f\n", (unsigned long)s.cutoffs,
+                  (unsigned long)s.first_cutoffs, s.branching(), s.effective_branching());
+    Serial.printf("TT hits %lu/%lu\n", (unsigned long)s.tt_hits, (unsigned long)s.tt_probes);
+}
 
-    vTaskDelete(NULL);
+// Line commands on the serial port
+static void poll_serial_commands() {
+    static char line[32];
+    static size_t len = 0;
+    while (Serial.available()) {
+        char ch = (char)Serial.read();
+        if (ch != '\n' && ch != '\r') {
+            if (len < sizeof(line) - 1) line[len++] = ch;
+            continue;
+        }
+        if (len == 0) continue;
+        line[len] = '\0';
+        len = 0;
+        if (!strcmp(line, "stats")) print_search_stats();
+        else Serial.println("Commands: stats");
+    }
 }
 
-void start_ai_task() {
+void request_ai_move() {
     is_ai_thinking = true;
-    xTaskCreate(ai_play_task, "AI_Gomoku", 16000, NULL, 1, NULL);
+    if (status_label) lv_label_set_text(status_label, "AI Thinking...");
+    queue_ai_job(AI_JOB_MOVE);
 }
 
 // =================================================================
@@ -359,76 +652,33 @@ void start_ai_task() {
 // =================================================================
 
 static char check_win_and_fill_positions() {
-    int empty_cells = 0;
-    
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            char current_player = board[i][j];
-            if (current_player == ' ') {
-                empty_cells++;
-                continue;
-            }
-
-            // 1. Horizontal
-            if (j <= BOARD_SIZE - WIN_COUNT) {
-                int count = 0;
-                for (int k = 0; k < WIN_COUNT; k++) {
-                    if (board[i][j + k] == current_player) count++;
-                    else break;
-                }
-                if (count == WIN_COUNT) {
-                    for (int k = 0; k < WIN_COUNT; k++) { win_pos_r[k] = i; win_pos_c[k] = j + k; }
-                    win_positions_valid = true;
-                    return current_player;
-                }
-            }
-
-            // 2. Vertical
-            if (i <= BOARD_SIZE - WIN_COUNT) {
-                int count = 0;
-                for (int k = 0; k < WIN_COUNT; k++) {
-                    if (board[i + k][j] == current_player) count++;
-                    else break;
-                }
-                if (count == WIN_COUNT) {
-                    for (int k = 0; k < WIN_COUNT; k++) { win_pos_r[k] = i + k; win_pos_c[k] = j; }
-                    win_positions_valid = true;
-                    return current_player;
-                }
-            }
-
-            // 3. Diagonal "\"
-            if (i <= BOARD_SIZE - WIN_COUNT && j <= BOARD_SIZE - WIN_COUNT) {
-                int count = 0;
-                for (int k = 0; k < WIN_COUNT; k++) {
-                    if (board[i + k][j + k] == current_player) count++;
-                    else break;
-                }
-                if (count == WIN_COUNT) {
-                    for (int k = 0; k < WIN_COUNT; k++) { win_pos_r[k] = i + k; win_pos_c[k] = j + k; }
-                    win_positions_valid = true;
-                    return current_player;
-                }
-            }
-
-            // 4. Diagonal "/"
-            if (i <= BOARD_SIZE - WIN_COUNT && j >= WIN_COUNT - 1) {
-                int count = 0;
-                for (int k = 0; k < WIN_COUNT; k++) {
-                    if (board[i + k][j - k] == current_player) count++;
-                    else break;
-                }
-                if (count == WIN_COUNT) {
-                    for (int k = 0; k < WIN_COUNT; k++) { win_pos_r[k] = i + k; win_pos_c[k] = j - k; }
-                    win_positions_valid = true;
-                    return current_player;
-                }
+    // Starts of winning fives for each direction, found with shift-and-mask;
+    // the rule set decides which runs count (overlines, caro's blocked fives)
+    Bitboard fives[4];
+    Bitboard any_five = {0, 0};
+    BitPosition game_pos;
+    with_engine([&](auto& e) {
+        game_pos = e.pos;
+        for (int dir = 0; dir < 4; dir++) fives[dir] = e.five_starts(PLAYER_X, dir) | e.five_starts(PLAYER_O, dir);
+    });
+    for (int dir = 0; dir < 4; dir++) any_five = any_five | fives[dir];
+
+    if (bb_any(any_five)) {
+        int sq = bb_pop_lsb(any_five); // First in raster order, same as the old cell scan
+        for (int dir = 0; dir < 4; dir++) {
+            if (!bb_test(fives[dir], sq)) continue;
+            for (int k = 0; k < WIN_COUNT; k++) {
+                int cell = sq + k * BB_DIR_SHIFT[dir];
+                win_pos_r[k] = bb_row(cell);
+                win_pos_c[k] = bb_col(cell);
             }
+            win_positions_valid = true;
+            return bb_test(game_pos.stones[PLAYER_X], sq) ? 'X' : 'O';
         }
     }
 
     win_positions_valid = false;
-    return (empty_cells == 0) ? 'D' : ' ';
+    return bb_any(game_pos.empty()) ? ' ' : 'D';
 }
 
 static void stop_blinking() {
@@ -477,15 +727,23 @@ static void update_score_labels() {
 }
 
 void reset_game() {
+    abandon_ai(); // A search for the last game stops on its own; its move is dropped
+    clear_hint();
     stop_blinking();
     win_positions_valid = false;
     game_over = false;
     game_running = true; 
     move_count = 0;
+    ai_clock.reset(AI_CLOCK_BASE_MS, AI_CLOCK_INC_MS);
 
     start_with_x = !start_with_x;
+    if (current_rules == RULES_RENJU) start_with_x = true; // Black (X) always opens in renju
     currentPlayer = start_with_x ? 'X' : 'O';
 
+    with_engine([](auto& e) {
+        e.pos.clear();
+        e.pos.set_net(ai_net_ok && current_ai_level == AI_HARD ? &ai_net : nullptr);
+    });
     for (int i = 0; i < BOARD_SIZE; i++) {
         for (int j = 0; j < BOARD_SIZE; j++) {
             board[i][j] = ' ';
@@ -506,21 +764,28 @@ void reset_game() {
     
     if (mode_label) {
         if (current_mode == MODE_PVP) {
-            lv_label_set_text(mode_label, "Mode: PvP");
+            lv_label_set_text_fmt(mode_label, "Mode: PvP\n%s", RULE_NAMES[current_rules]);
         } else {
             const char* lvl = (current_ai_level == AI_EASY) ? "Easy" : 
-                              (current_ai_level == AI_MEDIUM) ? "Medium" : "Hard";
-            lv_label_set_text_fmt(mode_label, "PvE (%s)", lvl);
+                              (current_ai_level == AI_MEDIUM) ? "Medium" :
+                              (current_ai_level == AI_HARD) ? "Hard" : "MCTS";
+            lv_label_set_text_fmt(mode_label, "PvE (%s)\n%s", lvl, RULE_NAMES[current_rules]);
         }
     }
 
     if (current_mode == MODE_PVE && currentPlayer == 'O') {
-        start_ai_task();
+        request_ai_move();
     }
 }
 
 void make_move(int r, int c) {
+    clear_hint();
+    if (hint_pending) {
+        hint_pending = false;
+        ai_preempt.cancel(); // The hint was for the position before this move
+    }
     board[r][c] = currentPlayer;
+    with_engine([&](auto& e) { e.pos.make_move(bb_square(r, c), player_index(currentPlayer)); });
     move_count++;
 
     if (currentPlayer == 'X') {
@@ -534,6 +799,7 @@ void make_move(int r, int c) {
     char winner = check_win_and_fill_positions();
     if (winner != ' ') {
         game_over = true;
+        ai_preempt.cancel(); // Ends a ponder search: no reply will come
         if (winner == 'X') score_x++;
         if (winner == 'O') score_o++;
         update_score_labels();
@@ -557,7 +823,7 @@ void make_move(int r, int c) {
         lv_label_set_text(status_label, buf);
 
         if (current_mode == MODE_PVE && currentPlayer == 'O' && !game_over) {
-            start_ai_task();
+            request_ai_move();
         }
     }
 }
@@ -572,9 +838,15 @@ static void game_cell_cb(lv_event_t * e) {
     int row = index / BOARD_SIZE;
     int col = index % BOARD_SIZE;
 
-    if (board[row][col] == ' ') {
-        make_move(row, col);
+    if (board[row][col] != ' ') return;
+
+    bool forbidden = false;
+    if (currentPlayer == 'X') with_engine([&](auto& e) { forbidden = e.forbidden(bb_square(row, col)); });
+    if (forbidden) {
+        lv_label_set_text(status_label, "Forbidden!"); // Renju: double three, double four or overline
+        return;
     }
+    make_move(row, col);
 }
 
 // =================================================================
@@ -619,7 +891,7 @@ void create_menu_ui() {
     lv_label_set_text(title, "GOMOKU (CARO) ESP32");
     lv_obj_set_style_text_font(title, &lv_font_montserrat_22, 0);
     lv_obj_set_style_text_color(title, lv_color_white(), 0);
-    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 30);
+    lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 8);
 
     static lv_style_t style_btn;
     lv_style_init(&style_btn);
@@ -628,11 +900,11 @@ void create_menu_ui() {
     lv_style_set_height(&style_btn, 50);
     lv_style_set_radius(&style_btn, 10);
 
-    auto create_btn = [&](const char* txt, int y_ofs, lv_color_t color, lv_event_cb_t cb) {
+    auto create_btn = [&](const char* txt, int x_ofs, int y_ofs, lv_color_t color, lv_event_cb_t cb) {
         lv_obj_t* btn = lv_button_create(scr);
         lv_obj_add_style(btn, &style_btn, 0);
         lv_obj_set_style_bg_color(btn, color, 0);
-        lv_obj_align(btn, LV_ALIGN_CENTER, 0, y_ofs);
+        lv_obj_align(btn, LV_ALIGN_CENTER, x_ofs, y_ofs);
         
         lv_obj_t* lbl = lv_label_create(btn);
         lv_label_set_text(lbl, txt);
@@ -640,28 +912,50 @@ void create_menu_ui() {
         lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, NULL);
     };
 
-    create_btn("Player vs Player", -60, lv_palette_main(LV_PALETTE_BLUE), [](lv_event_t* e){
+    // Rule set: each tap moves to the next one, and it holds for the games that follow
+    lv_obj_t* rules_btn = lv_button_create(scr);
+    lv_obj_add_style(rules_btn, &style_btn, 0);
+    lv_obj_set_style_bg_color(rules_btn, lv_palette_main(LV_PALETTE_TEAL), 0);
+    lv_obj_set_height(rules_btn, 36);
+    lv_obj_align(rules_btn, LV_ALIGN_CENTER, 0, -98);
+    lv_obj_t* rules_lbl = lv_label_create(rules_btn);
+    lv_label_set_text_fmt(rules_lbl, "Rules: %s", RULE_NAMES[current_rules]);
+    lv_obj_center(rules_lbl);
+    lv_obj_add_event_cb(rules_btn, [](lv_event_t* e){
+        bool changed = select_rules((RuleSet)((current_rules + 1) % RULES_COUNT));
+        lv_label_set_text_fmt((lv_obj_t*)lv_event_get_user_data(e), changed ? "Rules: %s" : "Rules: %s (busy, tap again)",
+                              RULE_NAMES[current_rules]);
+    }, LV_EVENT_CLICKED, rules_lbl);
+
+    create_btn("Player vs Player", 0, -40, lv_palette_main(LV_PALETTE_BLUE), [](lv_event_t* e){
         current_mode = MODE_PVP;
         create_game_ui();
     });
 
-    create_btn("PvE - Easy", 0, lv_palette_main(LV_PALETTE_GREEN), [](lv_event_t* e){
+    // AI levels in a 2x2 grid
+    create_btn("PvE - Easy", -105, 30, lv_palette_main(LV_PALETTE_GREEN), [](lv_event_t* e){
         current_mode = MODE_PVE;
         current_ai_level = AI_EASY;
         create_game_ui();
     });
 
-    create_btn("PvE - Medium", 60, lv_palette_main(LV_PALETTE_ORANGE), [](lv_event_t* e){
+    create_btn("PvE - Medium", 105, 30, lv_palette_main(LV_PALETTE_ORANGE), [](lv_event_t* e){
         current_mode = MODE_PVE;
         current_ai_level = AI_MEDIUM;
         create_game_ui();
     });
 
-    create_btn("PvE - Hard", 120, lv_palette_main(LV_PALETTE_RED), [](lv_event_t* e){
+    create_btn("PvE - Hard", -105, 100, lv_palette_main(LV_PALETTE_RED), [](lv_event_t* e){
         current_mode = MODE_PVE;
         current_ai_level = AI_HARD;
         create_game_ui();
     });
+
+    create_btn("PvE - MCTS", 105, 100, lv_palette_main(LV_PALETTE_PURPLE), [](lv_event_t* e){
+        current_mode = MODE_PVE;
+        current_ai_level = AI_MCTS;
+        create_game_ui();
+    });
 }
 
 // --- GAME UI ---
@@ -697,6 +991,7 @@ void create_game_ui() {
     lv_obj_center(m_lbl);
     lv_obj_add_event_cb(menu_btn, [](lv_event_t* e){
         game_running = false;
+        abandon_ai();
         stop_blinking();
         create_menu_ui();
     }, LV_EVENT_CLICKED, NULL);
@@ -709,6 +1004,16 @@ void create_game_ui() {
     lv_obj_center(btn_label);
     lv_obj_add_event_cb(reset_btn, [](lv_event_t* e){ reset_game(); }, LV_EVENT_CLICKED, NULL);
 
+    lv_obj_t* hint_btn = lv_button_create(left_panel);
+    lv_obj_set_width(hint_btn, 70);
+    lv_obj_set_style_margin_top(hint_btn, 20, 0);
+    lv_obj_set_style_bg_color(hint_btn, lv_palette_main(LV_PALETTE_GREEN), 0);
+    lv_obj_t* h_lbl = lv_label_create(hint_btn);
+    lv_label_set_text(h_lbl, "Hint");
+    lv_obj_center(h_lbl);
+    lv_obj_add_event_cb(hint_btn, [](lv_event_t* e){ request_hint(); }, LV_EVENT_CLICKED, NULL);
+    if (current_rules == RULES_RENJU) lv_obj_add_state(hint_btn, LV_STATE_DISABLED);
+
     lv_obj_t* grid_cont = lv_obj_create(scr);
     lv_obj_set_size(grid_cont, grid_size, grid_size);
     lv_obj_set_grid_cell(grid_cont, LV_GRID_ALIGN_CENTER, 1, 1, LV_GRID_ALIGN_CENTER, 0, 1);
@@ -755,6 +1060,15 @@ void create_game_ui() {
         update_score_labels();
     }, LV_EVENT_CLICKED, NULL);
 
+    stats_label = nullptr;
+    if (AI_STATS_OVERLAY && current_mode == MODE_PVE) {
+        stats_label = lv_label_create(right_panel);
+        lv_obj_set_style_text_font(stats_label, &lv_font_montserrat_12, 0);
+        lv_obj_set_style_text_color(stats_label, lv_palette_main(LV_PALETTE_GREY), 0);
+        lv_obj_set_style_margin_top(stats_label, 10, 0);
+        show_search_stats();
+    }
+
     static lv_coord_t dsc_array[BOARD_SIZE + 1];
     for (int i = 0; i < BOARD_SIZE; i++) dsc_array[i] = cell_size;
     dsc_array[BOARD_SIZE] = LV_GRID_TEMPLATE_LAST;
@@ -797,13 +1111,45 @@ void setup ()
     }
     
     lvgl_mutex = xSemaphoreCreateMutex();
+    ai_engine_lock = xSemaphoreCreateMutex();
+    ai_jobs = xQueueCreate(AI_QUEUE_LENGTH, sizeof(AiJob));
+    ai_results = xQueueCreate(AI_QUEUE_LENGTH, sizeof(AiResult));
+    ai_hints = xQueueCreate(1, sizeof(AiHint));
+
+    tt_ok = tt.init();
+    if (!tt_ok) DEBUG_PRINTLN("TT alloc failed, searching without it");
+    engine_start();
+
+#if AI_BENCH_AT_BOOT
+    static Search bench_search; // Only takes RAM in a benchmark build
+    bench_search.tt = tt_ok ? &tt : nullptr;
+    caro_bench_run(bench_search, [](const char* line) { Serial.println(line); });
+#endif
+
+    size_t book_size = 0;
+    const void* book_data = caro_map_readonly(BOOK_PARTITION, &book_size);
+    if (ai_book.open(book_data, book_size)) {
+        DEBUG_PRINTF("Opening book: %u positions\n", ai_book.count);
+    } else {
+        DEBUG_PRINTLN("No opening book in the flash partition");
+    }
+    if (book_size > NNUE_PARTITION_OFFSET &&
+        ai_net.load((const uint8_t*)book_data + NNUE_PARTITION_OFFSET, book_size - NNUE_PARTITION_OFFSET)) {
+        ai_net_ok = true;
+        DEBUG_PRINTLN("NNUE evaluation for Hard");
+    } else {
+        DEBUG_PRINTLN("No NNUE net in the flash partition, Hard uses the pattern table");
+    }
     
     create_menu_ui(); 
+    lv_timer_create(ai_result_timer_cb, 20, NULL);
 
+    xTaskCreatePinnedToCore(ai_worker, "AI_Worker", AI_WORKER_STACK, NULL, 1, NULL, AI_WORKER_CORE);
     xTaskCreatePinnedToCore(lvglTask, "LVGL Task", 8192, NULL, 1, NULL, 0);
 }
 
 void loop ()
 {
+    poll_serial_commands();
     yield();
 }
\ No newline at end of file
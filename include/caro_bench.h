@@ -0,0 +1,253 @@
+/*
+    Fixed benchmark of the freestyle search: the same positions, searched to a
+    fixed depth from a cleared table, on Linux (tools/bench.cpp) or on the
+    device (AI_BENCH_AT_BOOT in the sketch).
+
+    The positions cover openings, middlegames from self-play at depth 3, and
+    tactics (a five to make or to stop, open threes, a double four). O is to
+    move in all of them. VCF/VCT are off, so only the alpha-beta and
+    quiescence searches are measured.
+
+    Output is CSV, one line per position and a total, so two runs can be
+    diffed:
+
+        name,depth,nodes,us,nps,eval_us,movegen_us,move
+
+    nodes and move depend only on the engine; they must not change in a pure
+    speedup. eval_us is the time spent evaluating: in the search's make/undo,
+    whose line updates rescore the position incrementally, and in
+    evaluate_board_gomoku(), which only reads that score (or runs the net's
+    output layer). movegen_us is the time in gen_moves(). Both are counted
+    only in a -DCARO_PROFILE build (0 otherwise) and converted from cycles at
+    a rate measured first.
+    The counters themselves cost time, so read nps from a build without them.
+*/
+#pragma once
+
+#include <stdio.h>
+#include "caro_search.h"
+
+struct BenchPosition {
+    const char* name;
+    int depth;
+    const char* rows[BOARD_SIZE]; // 'X', 'O' or '.'
+};
+
+static const BenchPosition BENCH_POSITIONS[] = {
+    { "open_1", 6, {
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        "....X.....",
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "open_9a", 6, {
+        "..........",
+        "..........",
+        "....XOX...",
+        "......O...",
+        "......OX..",
+        "......O...",
+        ".....XX...",
+        "..........",
+        "..........",
+        ".........." } },
+    { "open_9b", 6, {
+        "..........",
+        "..........",
+        "....OXO...",
+        "...O......",
+        "..OXX.....",
+        ".X........",
+        ".....X....",
+        "..........",
+        "..........",
+        ".........." } },
+    { "open_9c", 6, {
+        "..........",
+        "..........",
+        ".X.....O..",
+        "..X.O.....",
+        "...X......",
+        "..XOX.....",
+        ".....O....",
+        "..........",
+        "..........",
+        ".........." } },
+    { "mid_17a", 5, {
+        "..........",
+        "..........",
+        "....XOX...",
+        "......OX..",
+        ".....XOX..",
+        "....XOOOX.",
+        ".....XXO..",
+        "......O...",
+        "..........",
+        ".........." } },
+    { "mid_17b", 5, {
+        "..........",
+        "..........",
+        "..OXX.....",
+        "..XOO.....",
+        ".OXOX.O...",
+        "..XOX.....",
+        "..OX......",
+        "..X.......",
+        "..........",
+        ".........." } },
+    { "mid_17c", 5, {
+        "..........",
+        "..........",
+        "....O.....",
+        "...X......",
+        ".OX.......",
+        ".XOX.X.X..",
+        "XOOOOX....",
+        "...OX.....",
+        "..........",
+        ".........." } },
+    { "mid_25a", 5, {
+        "..........",
+        "..........",
+        "....XOX...",
+        "......OX..",
+        "..X..XOX..",
+        "...OXOOOX.",
+        "....OXXO..",
+        "...X.OOOX.",
+        ".......X..",
+        ".........." } },
+    { "mid_25b", 5, {
+        "..........",
+        "..........",
+        "..OXXX....",
+        "..XOO.X...",
+        ".OXOXOOOX.",
+        "..XOX.....",
+        "..OX......",
+        "..XXO.....",
+        ".O........",
+        ".........." } },
+    { "mid_25c", 5, {
+        "..........",
+        "..........",
+        "..........",
+        "...OXXXXO.",
+        "....XX.OX.",
+        "....OOXO..",
+        ".....XOO..",
+        "..X..O.O..",
+        "....O..XO.",
+        "...X.....X" } },
+    { "tac_make_five", 6, {
+        "..........",
+        "..........",
+        "....X.....",
+        "...X......",
+        "..X.......",
+        "..........",
+        "..........",
+        "..XOOOO...",
+        "....X.....",
+        ".........." } },
+    { "tac_block_four", 6, {
+        "..........",
+        "..........",
+        "..........",
+        "..OXXXX...",
+        "..........",
+        "....O.O...",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "tac_block_three", 6, {
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        "...XXX....",
+        "..........",
+        "...O.O....",
+        "..........",
+        "..........",
+        ".........." } },
+    { "tac_open_three", 6, {
+        "..........",
+        "..........",
+        "....XO....",
+        ".....OX...",
+        ".....O....",
+        "..........",
+        "..X.......",
+        ".......X..",
+        "..........",
+        ".........." } },
+    { "tac_double_four", 6, {
+        "..........",
+        "........X.",
+        "..X..X....",
+        ".....O....",
+        ".....O....",
+        ".XOOO.....",
+        ".....O....",
+        ".......X..",
+        "...X....X.",
+        ".........." } },
+};
+
+#define BENCH_POSITION_COUNT (int)(sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]))
+
+// Runs every position on search (single-threaded, its table cleared first) and passes each
+// CSV line to emit(const char*). depth_delta shifts all depths, e.g. -2 for a quick run;
+// with a net the positions evaluate with it.
+template <class S, class Emit>
+static void caro_bench_run(S& search, Emit emit, int depth_delta = 0, const NnueNet* net = nullptr) {
+    char line[128];
+    uint64_t total_nodes = 0;
+    int64_t total_us = 0;
+
+    // Cycles per 10 ms: short enough for a 32-bit counter
+    uint64_t c0 = caro_cycles();
+    int64_t t0 = caro_now_us();
+    while (caro_now_us() - t0 < 10000) {}
+    uint64_t cycles_per_10ms = std::max<uint64_t>(1, (uint32_t)(caro_cycles() - c0));
+
+    emit("name,depth,nodes,us,nps,eval_us,movegen_us,move");
+
+    for (int i = 0; i < BENCH_POSITION_COUNT; i++) {
+        const BenchPosition& b = BENCH_POSITIONS[i];
+        decltype(search.pos) root;
+        root.clear();
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int c = 0; c < BOARD_SIZE; c++) {
+                if (b.rows[r][c] == 'X') root.make_move(bb_square(r, c), PLAYER_X);
+                if (b.rows[r][c] == 'O') root.make_move(bb_square(r, c), PLAYER_O);
+            }
+        }
+        root.set_net(net);
+        if (search.tt) search.tt->clear();
+
+        int depth = std::max(1, b.depth + depth_delta);
+        t0 = caro_now_us();
+        SearchResult r = search.think(root, { depth, 0, 0, 0, QUIESCE_NODE_LIMIT, false });
+        int64_t us = std::max<int64_t>(1, caro_now_us() - t0);
+
+        snprintf(line, sizeof(line), "%s,%d,%u,%lld,%llu,%llu,%llu,r%dc%d", b.name, depth, (unsigned)r.stats.nodes, (long long)us,
+                 (unsigned long long)((uint64_t)r.stats.nodes * 1000000 / (uint64_t)us),
+                 (unsigned long long)(search.eval_cycles * 10000 / cycles_per_10ms),
+                 (unsigned long long)(search.movegen_cycles * 10000 / cycles_per_10ms), r.move.r, r.move.c);
+        emit(line);
+        total_nodes += r.stats.nodes;
+        total_us += us;
+    }
+
+    snprintf(line, sizeof(line), "total,,%llu,%lld,%llu,,,", (unsigned long long)total_nodes, (long long)total_us,
+             (unsigned long long)(total_nodes * 1000000 / (uint64_t)std::max<int64_t>(1, total_us)));
+    emit(line);
+}
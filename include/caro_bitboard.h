@@ -0,0 +1,224 @@
+/*
+    Bitboards for the 10x10 caro board.
+
+    Each row takes BOARD_SIZE + 1 bits: the 11th column is always 0 (padding), so
+    shifting a bit-plane along any of the 4 line directions never carries a stone
+    over into the next row. 10 rows * 11 bits = 110 bits, held in two 64-bit words.
+
+    Cell (r, c) lives at bit r * BB_STRIDE + c.
+    Horizontal / vertical / diagonal "\" / diagonal "/" are shifts by 1 / 11 / 12 / 10.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#define BOARD_SIZE 10
+#define WIN_COUNT 5
+
+#define BB_STRIDE (BOARD_SIZE + 1)
+#define BB_CELLS  (BOARD_SIZE * BB_STRIDE)
+
+struct Bitboard {
+    uint64_t lo = 0, hi = 0;
+};
+
+static inline Bitboard operator&(Bitboard a, Bitboard b) { return { a.lo & b.lo, a.hi & b.hi }; }
+static inline Bitboard operator|(Bitboard a, Bitboard b) { return { a.lo | b.lo, a.hi | b.hi }; }
+static inline Bitboard operator^(Bitboard a, Bitboard b) { return { a.lo ^ b.lo, a.hi ^ b.hi }; }
+static inline Bitboard operator~(Bitboard a) { return { ~a.lo, ~a.hi }; }
+
+// Shift towards higher indices: bit i of the result = bit i - n of a. 0 < n < 64.
+static inline Bitboard bb_shl(Bitboard a, int n) {
+    return { a.lo << n, (a.hi << n) | (a.lo >> (64 - n)) };
+}
+
+// Shift towards lower indices: bit i of the result = bit i + n of a. 0 < n < 64.
+static inline Bitboard bb_shr(Bitboard a, int n) {
+    return { (a.lo >> n) | (a.hi << (64 - n)), a.hi >> n };
+}
+
+static inline bool bb_any(Bitboard a) { return (a.lo | a.hi) != 0; }
+
+static inline int bb_popcount(Bitboard a) {
+    return __builtin_popcountll(a.lo) + __builtin_popcountll(a.hi);
+}
+
+static inline int bb_square(int r, int c) { return r * BB_STRIDE + c; }
+static inline int bb_row(int sq) { return sq / BB_STRIDE; }
+static inline int bb_col(int sq) { return sq % BB_STRIDE; }
+
+static inline Bitboard bb_from_square(int sq) {
+    return (sq < 64) ? Bitboard{ 1ULL << sq, 0 } : Bitboard{ 0, 1ULL << (sq - 64) };
+}
+
+static inline bool bb_test(Bitboard a, int sq) {
+    return (sq < 64) ? ((a.lo >> sq) & 1) : ((a.hi >> (sq - 64)) & 1);
+}
+
+static inline void bb_set(Bitboard& a, int sq) {
+    if (sq < 64) a.lo |= 1ULL << sq; else a.hi |= 1ULL << (sq - 64);
+}
+
+static inline void bb_clear(Bitboard& a, int sq) {
+    if (sq < 64) a.lo &= ~(1ULL << sq); else a.hi &= ~(1ULL << (sq - 64));
+}
+
+// Returns and clears the lowest set bit. a must be non-zero.
+static inline int bb_pop_lsb(Bitboard& a) {
+    if (a.lo) {
+        int sq = __builtin_ctzll(a.lo);
+        a.lo &= a.lo - 1;
+        return sq;
+    }
+    int sq = 64 + __builtin_ctzll(a.hi);
+    a.hi &= a.hi - 1;
+    return sq;
+}
+
+static constexpr uint64_t bb_board_word(int word, int sq) {
+    return (sq >= BB_CELLS) ? 0 :
+        (((sq % BB_STRIDE) < BOARD_SIZE && sq / 64 == word) ? (1ULL << (sq % 64)) : 0) | bb_board_word(word, sq + 1);
+}
+
+// Every real cell (no padding column, no spare bits after the last row).
+static constexpr Bitboard BB_BOARD = { bb_board_word(0, 0), bb_board_word(1, 0) };
+
+// Shift per direction: horizontal, vertical, diagonal "\", diagonal "/".
+static const int BB_DIR_SHIFT[4] = { 1, BB_STRIDE, BB_STRIDE + 1, BB_STRIDE - 1 };
+
+// BB_NEAR.mask[range - 1][sq]: cells within `range` (1 or 2) king steps of sq, sq included.
+struct NearMasks {
+    Bitboard mask[2][BB_CELLS];
+
+    constexpr NearMasks() : mask() {
+        for (int range = 1; range <= 2; range++) {
+            for (int r = 0; r < BOARD_SIZE; r++) {
+                for (int c = 0; c < BOARD_SIZE; c++) {
+                    Bitboard& m = mask[range - 1][r * BB_STRIDE + c];
+                    for (int nr = r - range; nr <= r + range; nr++) {
+                        for (int nc = c - range; nc <= c + range; nc++) {
+                            if (nr < 0 || nr >= BOARD_SIZE || nc < 0 || nc >= BOARD_SIZE) continue;
+                            int sq = nr * BB_STRIDE + nc;
+                            if (sq < 64) m.lo |= 1ULL << sq; else m.hi |= 1ULL << (sq - 64);
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+static constexpr NearMasks BB_NEAR{};
+
+// Grows every stone into its 8 surrounding cells, clipped to BB_BOARD.
+static inline Bitboard bb_dilate(Bitboard a) {
+    Bitboard h = (a | bb_shl(a, 1) | bb_shr(a, 1)) & BB_BOARD;
+    return (h | bb_shl(h, BB_STRIDE) | bb_shr(h, BB_STRIDE)) & BB_BOARD;
+}
+
+// Cells within `range` king steps of any stone in a (the search's move candidates).
+static inline Bitboard bb_neighbors(Bitboard a, int range) {
+    for (int i = 0; i < range; i++) a = bb_dilate(a);
+    return a;
+}
+
+// Bit i is set when at least `len` stones in a row start at cell i along `shift`.
+static inline Bitboard bb_runs(Bitboard a, int shift, int len) {
+    Bitboard r = a;
+    for (int k = 1; k < len; k++) r = r & bb_shr(a, k * shift);
+    return r;
+}
+
+// Bit i is set when the `len` cells from i along `shift` match the pattern:
+// bit j of p_mask set -> stone of `p` at offset j, clear -> empty cell.
+static inline Bitboard bb_window(Bitboard p, Bitboard empty, int shift, int len, unsigned p_mask) {
+    Bitboard w = (p_mask & 1) ? p : empty;
+    for (int j = 1; j < len; j++) w = w & bb_shr(((p_mask >> j) & 1) ? p : empty, j * shift);
+    return w;
+}
+
+// Moves the window starts in w onto the cell at `offset` steps along `shift`.
+static inline Bitboard bb_window_cell(Bitboard w, int shift, int offset) {
+    return offset ? bb_shl(w, offset * shift) : w;
+}
+
+// Empty cells where `p` completes five (gapped shapes such as XX_XX included).
+static inline Bitboard bb_five_cells(Bitboard p, Bitboard empty) {
+    Bitboard cells = { 0, 0 };
+    for (int d = 0; d < 4; d++) {
+        for (int k = 0; k < WIN_COUNT; k++) {
+            Bitboard w = bb_window(p, empty, BB_DIR_SHIFT[d], WIN_COUNT, 0x1Fu & ~(1u << k));
+            if (bb_any(w)) cells = cells | bb_window_cell(w, BB_DIR_SHIFT[d], k);
+        }
+    }
+    return cells;
+}
+
+// Empty cells where a stone of `p` makes a four: some 5-cell window then holds 4 stones and 1 empty cell.
+static inline Bitboard bb_four_cells(Bitboard p, Bitboard empty) {
+    Bitboard cells = { 0, 0 };
+    for (int d = 0; d < 4; d++) {
+        for (int k1 = 0; k1 < WIN_COUNT; k1++) {
+            for (int k2 = k1 + 1; k2 < WIN_COUNT; k2++) {
+                Bitboard w = bb_window(p, empty, BB_DIR_SHIFT[d], WIN_COUNT, 0x1Fu & ~(1u << k1) & ~(1u << k2));
+                if (bb_any(w)) cells = cells | bb_window_cell(w, BB_DIR_SHIFT[d], k1) | bb_window_cell(w, BB_DIR_SHIFT[d], k2);
+            }
+        }
+    }
+    return cells;
+}
+
+// Empty cells where a stone of `p` makes an open three: a 6-cell window _????_ whose
+// middle then holds 3 stones and 1 empty cell, so one more stone gives _XXXX_.
+static inline Bitboard bb_three_cells(Bitboard p, Bitboard empty) {
+    Bitboard cells = { 0, 0 };
+    for (int d = 0; d < 4; d++) {
+        for (int k1 = 1; k1 <= 4; k1++) {
+            for (int k2 = k1 + 1; k2 <= 4; k2++) {
+                Bitboard w = bb_window(p, empty, BB_DIR_SHIFT[d], 6, 0x1Eu & ~(1u << k1) & ~(1u << k2));
+                if (bb_any(w)) cells = cells | bb_window_cell(w, BB_DIR_SHIFT[d], k1) | bb_window_cell(w, BB_DIR_SHIFT[d], k2);
+            }
+        }
+    }
+    return cells;
+}
+
+// Cells that stop every open three of `p` from becoming a straight four: the
+// intersection of the empty cells of all _XXX?_ style windows. Returns false if p has no open three.
+static inline bool bb_three_defences(Bitboard p, Bitboard empty, Bitboard& defences) {
+    bool found = false;
+    defences = BB_BOARD;
+    for (int d = 0; d < 4; d++) {
+        int s = BB_DIR_SHIFT[d];
+        for (int k = 1; k <= 4; k++) {
+            Bitboard w = bb_window(p, empty, s, 6, 0x1Eu & ~(1u << k));
+            while (bb_any(w)) {
+                int i = bb_pop_lsb(w);
+                defences = defences & (bb_from_square(i) | bb_from_square(i + k * s) | bb_from_square(i + 5 * s));
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+static inline bool bb_has_five(Bitboard a) {
+    for (int d = 0; d < 4; d++) {
+        if (bb_any(bb_runs(a, BB_DIR_SHIFT[d], WIN_COUNT))) return true;
+    }
+    return false;
+}
+
+// --- Position: one bit-plane per player ---
+enum { PLAYER_X = 0, PLAYER_O = 1 };
+
+struct BitPosition {
+    Bitboard stones[2];
+
+    void clear() { stones[PLAYER_X] = { 0, 0 }; stones[PLAYER_O] = { 0, 0 }; }
+    Bitboard occupied() const { return stones[PLAYER_X] | stones[PLAYER_O]; }
+    Bitboard empty() const { return ~occupied() & BB_BOARD; }
+};
+
+static inline int player_index(char p) { return (p == 'X') ? PLAYER_X : PLAYER_O; }
+static inline char player_char(int p) { return (p == PLAYER_X) ? 'X' : 'O'; }
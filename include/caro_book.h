@@ -0,0 +1,114 @@
+/*
+    Opening book: a sorted table of position keys and the move to play, read
+    in place from memory-mapped flash (or a mapped file on Linux).
+
+    Positions are stored once per symmetry class. The key is the smallest
+    Zobrist key of the 8 rotations / reflections of the position, and the move
+    is stored in that same orientation; lookup maps it back to the board.
+
+    File layout (little-endian, like both targets):
+        BookHeader    16 bytes
+        uint64_t keys[count]   sorted ascending
+        uint8_t  moves[count]  square (bb_square) in the canonical orientation
+
+    tools/make_book.cpp writes it. On the device the raw file goes into the
+    "spiffs" data partition (no filesystem on top), e.g. with the default
+    partition table:
+        esptool.py --chip esp32s3 write_flash 0x290000 book/caro_book.bin
+*/
+#pragma once
+
+#include <string.h>
+#include "caro_platform.h"
+#include "caro_position.h"
+
+#define BOOK_MAGIC     0x314B4243 // "CBK1"
+#define BOOK_PARTITION "spiffs"
+#define BOOK_SYMMETRIES 8
+#define BOOK_LOST      0xFE // Move byte of a position proven lost for the side to move (tools/solve_pn.cpp)
+
+struct BookHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t max_stones; // Positions with more stones than this are never in the book
+    uint32_t reserved;
+};
+
+// Symmetry t: bit 0 transposes, bit 1 mirrors the rows, bit 2 mirrors the columns (in that order).
+static inline int book_transform(int sq, int t) {
+    int r = bb_row(sq), c = bb_col(sq);
+    if (t & 1) { int tmp = r; r = c; c = tmp; }
+    if (t & 2) r = BOARD_SIZE - 1 - r;
+    if (t & 4) c = BOARD_SIZE - 1 - c;
+    return bb_square(r, c);
+}
+
+static inline int book_inverse(int sq, int t) {
+    int r = bb_row(sq), c = bb_col(sq);
+    if (t & 2) r = BOARD_SIZE - 1 - r;
+    if (t & 4) c = BOARD_SIZE - 1 - c;
+    if (t & 1) { int tmp = r; r = c; c = tmp; }
+    return bb_square(r, c);
+}
+
+// Smallest key over the 8 symmetries with `player` to move; *sym gets the symmetry that produced it.
+static inline uint64_t book_key(const BitPosition& pos, int player, int* sym) {
+    uint64_t keys[BOOK_SYMMETRIES];
+    uint64_t side = (player == PLAYER_X) ? ZOBRIST.side : 0;
+    for (int t = 0; t < BOOK_SYMMETRIES; t++) keys[t] = side;
+
+    for (int p = 0; p < 2; p++) {
+        Bitboard s = pos.stones[p];
+        while (bb_any(s)) {
+            int sq = bb_pop_lsb(s);
+            for (int t = 0; t < BOOK_SYMMETRIES; t++) keys[t] ^= ZOBRIST.stone[p][book_transform(sq, t)];
+        }
+    }
+
+    int best = 0;
+    for (int t = 1; t < BOOK_SYMMETRIES; t++) {
+        if (keys[t] < keys[best]) best = t;
+    }
+    if (sym) *sym = best;
+    return keys[best];
+}
+
+struct OpeningBook {
+    const uint64_t* keys = nullptr;
+    const uint8_t* moves = nullptr;
+    uint32_t count = 0;
+    uint32_t max_stones = 0;
+
+    // Checks the header and sizes; the data must stay mapped while the book is used
+    bool open(const void* data, size_t size) {
+        count = 0;
+        BookHeader h;
+        if (!data || size < sizeof(h)) return false;
+        memcpy(&h, data, sizeof(h));
+        if (h.magic != BOOK_MAGIC) return false;
+        if (size < sizeof(h) + (size_t)h.count * (sizeof(uint64_t) + 1)) return false;
+
+        keys = (const uint64_t*)((const uint8_t*)data + sizeof(h));
+        moves = (const uint8_t*)(keys + h.count);
+        count = h.count;
+        max_stones = h.max_stones;
+        return true;
+    }
+
+    // Book move for `player` in pos as a board square, or -1
+    int probe(const BitPosition& pos, int player) const {
+        if (count == 0 || bb_popcount(pos.occupied()) > (int)max_stones) return -1;
+        int sym;
+        uint64_t key = book_key(pos, player, &sym);
+
+        uint32_t lo = 0, hi = count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (keys[mid] < key) lo = mid + 1; else hi = mid;
+        }
+        if (lo == count || keys[lo] != key || moves[lo] >= BB_CELLS) return -1;
+
+        int sq = book_inverse(moves[lo], sym);
+        return bb_test(pos.empty(), sq) ? sq : -1;
+    }
+};
@@ -0,0 +1,369 @@
+/*
+    Monte Carlo tree search, the alternative to the alpha-beta Search.
+
+    Every iteration walks down the tree by UCT, expands the leaf once it has
+    been visited MCTS_EXPAND_VISITS times, plays a random game from there and
+    backs the result up. Playouts run on bare bitboards: a player who can make
+    five does, a player facing a five blocks it, anything else is a random cell
+    next to the stones, half the time one touching the last stone. The root
+    always has O to move, like Search.
+
+    Nodes come from a fixed arena (PSRAM on the device) handed out by a bump
+    index. After the AI's move and the human's reply, the subtree under those
+    two moves becomes the new root and keeps its statistics; the arena is only
+    wiped when it is more than half full at the start of a move.
+
+    With threads > 1 (meant for Linux hosts) all threads share one tree. A
+    thread walking through a node adds MCTS_VIRTUAL_LOSS lost visits to it until
+    its playout is backed up, which steers the other threads to other lines.
+
+    Under Renju the tree only holds legal moves for X; in a playout X's random
+    move is checked once and a forbidden one loses, as it would over the board.
+*/
+#pragma once
+
+#include <math.h>
+#include <atomic>
+#include "caro_platform.h"
+#include "caro_smp.h"
+
+#define MCTS_DEFAULT_NODES (1u << 17) // 131072 nodes * 16 bytes = 2 MB of PSRAM
+#define MCTS_EXPAND_VISITS 4
+#define MCTS_VIRTUAL_LOSS  3
+#define MCTS_UCT_C         1.2f
+#define MCTS_CHECK_ITERS   64   // The clock is read once every this many iterations (power of 2)
+#define MCTS_YIELD_ITERS   1024 // caro_yield() interval of the calling thread
+#define MCTS_MAX_THREADS   SMP_MAX_THREADS
+
+enum { MCTS_LEAF, MCTS_EXPANDING, MCTS_EXPANDED };
+
+struct MctsNode {
+    std::atomic<int32_t> visits;
+    std::atomic<int32_t> score; // 2 per win, 1 per draw, for the player who moved into this node
+    uint32_t first_child;       // Arena index, valid once state is MCTS_EXPANDED
+    uint8_t move;
+    uint8_t child_count;
+    std::atomic<uint8_t> state;
+    uint8_t won;                // The move into this node made five
+};
+
+template <class Rules>
+struct BasicMcts {
+    int threads = 1;                         // Linux only in practice, see the file comment
+    CancelCheck cancel;                      // Optional, polled every MCTS_CHECK_ITERS playouts
+
+    bool init(uint32_t max_nodes = MCTS_DEFAULT_NODES) {
+        release();
+        nodes = (MctsNode*)caro_alloc_large((size_t)max_nodes * sizeof(MctsNode));
+        if (!nodes) return false;
+        capacity = max_nodes;
+        reset_tree();
+        return true;
+    }
+
+    void release() {
+        if (nodes) caro_free_large(nodes);
+        nodes = nullptr;
+        capacity = 0;
+    }
+
+    bool ready() const { return nodes != nullptr; }
+
+    // Best move for O in root. limits.budget_ms bounds the time; max_iterations (0 = none) the playouts.
+    SearchResult think(const BasicPosition<Rules>& root, const SearchLimits& limits, uint32_t max_iterations = 0) {
+        CaroNoAllocScope no_alloc("Mcts::think");
+        int64_t start_us = caro_now_us();
+        SearchResult result = { {-1, -1}, 0, SOURCE_MCTS, {} };
+        if (!nodes) return result;
+
+        reuse_or_reset(root);
+        root_pos = root;
+        deadline_us = limits.budget_ms ? start_us + (int64_t)limits.budget_ms * 1000 : INT64_MAX;
+        iteration_limit = max_iterations;
+        iterations.store(0);
+        stop.store(false);
+
+        int n = std::max(1, std::min(threads, MCTS_MAX_THREADS));
+        int started = 1;
+        for (; started < n; started++) {
+            helper_args[started] = { this, (uint64_t)started };
+            if (!caro_thread_start(helpers[started], helper_main, &helper_args[started], -1)) break;
+        }
+        run(0x9E3779B97F4A7C15ULL ^ (uint64_t)start_us, true);
+        stop.store(true);
+        for (int i = 1; i < started; i++) caro_thread_join(helpers[i]);
+
+        // Most visited child: the most robust choice
+        MctsNode& r = nodes[root_index];
+        if (r.state.load() == MCTS_EXPANDED) {
+            int best_visits = -1;
+            for (int i = 0; i < r.child_count; i++) {
+                MctsNode& c = nodes[r.first_child + i];
+                int v = c.visits.load();
+                if (v > best_visits) {
+                    best_visits = v;
+                    result.move = { bb_row(c.move), bb_col(c.move) };
+                    result.score = v ? (int)((int64_t)c.score.load() * 500 / v) : 0; // O's win rate in 1/1000
+                }
+            }
+        }
+        result.stats.nodes = iterations.load(); // Playouts
+        result.stats.depth = line_length();
+        result.stats.elapsed_us = (uint32_t)(caro_now_us() - start_us);
+        return result;
+    }
+
+    uint32_t nodes_used() const { return next_free.load(); }
+    uint32_t reused_visits = 0; // Playouts inherited from the previous move by the last think()
+
+private:
+    struct HelperArg {
+        BasicMcts* self;
+        uint64_t seed;
+    };
+
+    MctsNode* nodes = nullptr;
+    uint32_t capacity = 0;
+    std::atomic<uint32_t> next_free{0};
+    uint32_t root_index = 0;
+    Bitboard root_stones[2];    // Position the tree root stands for
+
+    BasicPosition<Rules> root_pos;
+    int64_t deadline_us = 0;
+    uint32_t iteration_limit = 0;
+    std::atomic<uint32_t> iterations{0};
+    std::atomic<bool> stop{false};
+    CaroThread helpers[MCTS_MAX_THREADS];
+    HelperArg helper_args[MCTS_MAX_THREADS];
+
+    static void helper_main(void* arg) {
+        HelperArg* a = (HelperArg*)arg;
+        a->self->run(0xD1B54A32D192ED03ULL * (a->seed + 1), false);
+    }
+
+    static uint64_t next_random(uint64_t& s) {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return s;
+    }
+
+    // n-th set bit of a
+    static int nth_square(Bitboard a, int n) {
+        while (n--) bb_pop_lsb(a);
+        return bb_pop_lsb(a);
+    }
+
+    void init_node(uint32_t i, int move, bool won) {
+        nodes[i].visits.store(0);
+        nodes[i].score.store(0);
+        nodes[i].first_child = 0;
+        nodes[i].move = (uint8_t)move;
+        nodes[i].child_count = 0;
+        nodes[i].state.store(MCTS_LEAF);
+        nodes[i].won = won;
+    }
+
+    void reset_tree() {
+        next_free.store(1);
+        root_index = 0;
+        init_node(0, TT_NO_MOVE, false);
+        root_stones[0] = root_stones[1] = Bitboard{ 0, 0 };
+    }
+
+    // Keeps the subtree reached by the two moves played since the last think(), if there is one
+    void reuse_or_reset(const BitPosition& root) {
+        reused_visits = 0;
+        Bitboard new_o = root.stones[PLAYER_O] & ~root_stones[PLAYER_O];
+        Bitboard new_x = root.stones[PLAYER_X] & ~root_stones[PLAYER_X];
+        bool same_line = bb_popcount(new_o) == 1 && bb_popcount(new_x) == 1 &&
+                         bb_popcount(root.stones[PLAYER_O]) == bb_popcount(root_stones[PLAYER_O]) + 1 &&
+                         bb_popcount(root.stones[PLAYER_X]) == bb_popcount(root_stones[PLAYER_X]) + 1;
+
+        uint32_t idx = root_index;
+        if (same_line && next_free.load() <= capacity / 2) {
+            Bitboard o = new_o, x = new_x;
+            int moves[2] = { bb_pop_lsb(o), bb_pop_lsb(x) };
+            for (int k = 0; k < 2 && idx != UINT32_MAX; k++) idx = find_child(idx, moves[k]);
+        } else {
+            idx = UINT32_MAX;
+        }
+
+        if (idx == UINT32_MAX) {
+            reset_tree();
+        } else {
+            root_index = idx;
+            reused_visits = (uint32_t)nodes[idx].visits.load();
+        }
+        root_stones[PLAYER_O] = root.stones[PLAYER_O];
+        root_stones[PLAYER_X] = root.stones[PLAYER_X];
+    }
+
+    // Length of the most visited line from the root
+    int line_length() const {
+        int len = 0;
+        uint32_t idx = root_index;
+        while (nodes[idx].state.load() == MCTS_EXPANDED && len < BOARD_SIZE * BOARD_SIZE) {
+            const MctsNode& n = nodes[idx];
+            uint32_t best = n.first_child;
+            for (int i = 1; i < n.child_count; i++) {
+                if (nodes[n.first_child + i].visits.load() > nodes[best].visits.load()) best = n.first_child + i;
+            }
+            if (nodes[best].visits.load() == 0) break;
+            idx = best;
+            len++;
+        }
+        return len;
+    }
+
+    uint32_t find_child(uint32_t idx, int move) const {
+        const MctsNode& n = nodes[idx];
+        if (n.state.load() != MCTS_EXPANDED) return UINT32_MAX;
+        for (int i = 0; i < n.child_count; i++) {
+            if (nodes[n.first_child + i].move == move) return n.first_child + i;
+        }
+        return UINT32_MAX;
+    }
+
+    // Legal children: a win if there is one, else the blocks of the opponent's five, else cells next to a stone
+    static Bitboard child_moves(const Bitboard stones[2], int player) {
+        Bitboard empty = ~(stones[0] | stones[1]) & BB_BOARD;
+        Bitboard wins = rule_five_cells<Rules>(stones[player], stones[player ^ 1], empty, player);
+        if (bb_any(wins)) return bb_from_square(bb_pop_lsb(wins));
+        Bitboard blocks = rule_five_cells<Rules>(stones[player ^ 1], stones[player], empty, player ^ 1);
+        if (bb_any(blocks)) return rule_legal<Rules>(blocks, stones, player);
+        Bitboard near = bb_neighbors(stones[0] | stones[1], 1) & empty;
+        if (!bb_any(stones[0] | stones[1])) near = bb_from_square(bb_square(BOARD_SIZE / 2, BOARD_SIZE / 2));
+        return rule_legal<Rules>(near, stones, player);
+    }
+
+    bool expand(uint32_t idx, const Bitboard stones[2], int player) {
+        MctsNode& n = nodes[idx];
+        uint8_t expected = MCTS_LEAF;
+        if (!n.state.compare_exchange_strong(expected, MCTS_EXPANDING)) return false;
+
+        Bitboard moves = child_moves(stones, player);
+        int count = bb_popcount(moves);
+        // Reserved only if they fit: a failed expansion leaves next_free as it was
+        uint32_t first = next_free.load();
+        do {
+            if (count == 0 || first + count > capacity) {
+                n.state.store(MCTS_LEAF); // Arena full (or board full): keep playing out from here
+                return false;
+            }
+        } while (!next_free.compare_exchange_weak(first, first + (uint32_t)count));
+        for (int i = 0; i < count; i++) {
+            int sq = bb_pop_lsb(moves);
+            Bitboard after = stones[player];
+            bb_set(after, sq);
+            init_node(first + i, sq, rule_has_five<Rules>(after, stones[player ^ 1], player));
+        }
+        n.first_child = first;
+        n.child_count = (uint8_t)count;
+        n.state.store(MCTS_EXPANDED);
+        return true;
+    }
+
+    uint32_t select_child(uint32_t idx) const {
+        const MctsNode& n = nodes[idx];
+        float log_parent = logf((float)std::max(n.visits.load(), 1));
+        uint32_t best = n.first_child;
+        float best_value = -1.0f;
+        for (int i = 0; i < n.child_count; i++) {
+            const MctsNode& c = nodes[n.first_child + i];
+            int v = c.visits.load();
+            if (c.won) return n.first_child + i;
+            if (v == 0) return n.first_child + i; // Children are tried once each, in raster order
+            float value = (float)c.score.load() / (2.0f * v) + MCTS_UCT_C * sqrtf(log_parent / v);
+            if (value > best_value) {
+                best_value = value;
+                best = n.first_child + i;
+            }
+        }
+        return best;
+    }
+
+    // Random game from stones with player to move, after `last` (-1 = none).
+    // 2 = player wins, 1 = draw, 0 = player loses.
+    static int playout(Bitboard stones[2], int player, int last, uint64_t& rng) {
+        int p = player;
+        Bitboard near = bb_neighbors(stones[0] | stones[1], 1);
+        Bitboard empty = ~(stones[0] | stones[1]) & BB_BOARD;
+        // Cells where each side completes five; only the mover's set changes with a move, except in caro
+        Bitboard fives[2] = { rule_five_cells<Rules>(stones[0], stones[1], empty, 0),
+                              rule_five_cells<Rules>(stones[1], stones[0], empty, 1) };
+        for (;;) {
+            if (bb_any(fives[p] & empty)) return (p == player) ? 2 : 0;
+
+            // Forced block, else half the time a cell touching the last stone (replies are local), else anywhere near
+            Bitboard moves = fives[p ^ 1] & empty;
+            if (!bb_any(moves) && last >= 0 && (next_random(rng) & 1)) moves = BB_NEAR.mask[0][last] & empty;
+            if (!bb_any(moves)) moves = near & empty;
+            if (!bb_any(moves)) moves = empty;
+            int count = bb_popcount(moves);
+            if (count == 0) return 1;
+
+            int sq = nth_square(moves, (int)(next_random(rng) % (uint64_t)count));
+            if constexpr (Rules::black_restricted) {
+                if (p == PLAYER_X && rule_forbidden<Rules>(stones[PLAYER_X], stones[PLAYER_O], sq)) return (p == player) ? 0 : 2;
+            }
+            bb_set(stones[p], sq);
+            bb_clear(empty, sq);
+            near = near | BB_NEAR.mask[0][sq];
+            fives[p] = rule_five_cells<Rules>(stones[p], stones[p ^ 1], empty, p);
+            if constexpr (!Rules::blocked_five_wins) fives[p ^ 1] = rule_five_cells<Rules>(stones[p ^ 1], stones[p], empty, p ^ 1);
+            last = sq;
+            p ^= 1;
+        }
+    }
+
+    void run(uint64_t rng, bool main_thread) {
+        uint32_t path[BOARD_SIZE * BOARD_SIZE + 1];
+        for (uint32_t it = 1; ; it++) {
+            if (stop.load(std::memory_order_relaxed)) break;
+            if ((it & (MCTS_CHECK_ITERS - 1)) == 0) {
+                if (caro_now_us() > deadline_us || cancel.cancelled()) break;
+                if (main_thread && (it & (MCTS_YIELD_ITERS - 1)) == 0) caro_yield();
+            }
+            if (iteration_limit && iterations.load(std::memory_order_relaxed) >= iteration_limit) break;
+            iterate(rng, path);
+            iterations.fetch_add(1, std::memory_order_relaxed);
+        }
+        stop.store(true);
+    }
+
+    void iterate(uint64_t& rng, uint32_t* path) {
+        Bitboard stones[2] = { root_pos.stones[0], root_pos.stones[1] };
+        int player = PLAYER_O; // To move at the current node
+        int depth = 0;
+        uint32_t idx = root_index;
+        path[depth++] = idx;
+        nodes[idx].visits.fetch_add(MCTS_VIRTUAL_LOSS);
+
+        // Selection, with a virtual loss on every node on the way
+        int result = -1; // For the player to move at idx: 2 win, 1 draw, 0 loss
+        for (;;) {
+            MctsNode& n = nodes[idx];
+            if (n.won) { result = 0; break; } // The move into this node won
+            if (n.state.load() != MCTS_EXPANDED) {
+                if (n.visits.load() < MCTS_EXPAND_VISITS + MCTS_VIRTUAL_LOSS || !expand(idx, stones, player)) break;
+            }
+            idx = select_child(idx);
+            bb_set(stones[player], nodes[idx].move);
+            player ^= 1;
+            path[depth++] = idx;
+            nodes[idx].visits.fetch_add(MCTS_VIRTUAL_LOSS);
+        }
+
+        if (result < 0) result = playout(stones, player, depth > 1 ? nodes[idx].move : -1, rng);
+
+        // Back up: the node at path[k] scores for the player who moved into it, i.e. not the player to move there
+        for (int k = depth - 1; k >= 0; k--) {
+            nodes[path[k]].visits.fetch_add(1 - MCTS_VIRTUAL_LOSS);
+            nodes[path[k]].score.fetch_add(2 - result);
+            result = 2 - result;
+        }
+    }
+};
+
+using Mcts = BasicMcts<FreestyleRules>;
@@ -0,0 +1,220 @@
+/*
+    Small quantized neural evaluator (NNUE style), the alternative to the
+    pattern-table score of caro_position.h.
+
+    The inputs are the 5-cell windows of every line. A window holding stones
+    of one player only is a feature, identified by that player and which of
+    its five cells are taken (2 x 31 features); empty windows and windows with
+    both colours count for nothing. A feature occurs once per window showing
+    it, so the first layer is a sum of weight columns:
+
+        acc    = l1_bias + l1_weights[f] summed over live windows   (int16 x NNUE_HIDDEN)
+        hidden = clamp(acc, 0, NNUE_QA)                             (clipped ReLU)
+        score  = (out_bias + sum of hidden * out_weights) * out_mul >> 16
+
+    A stone changes at most five windows per direction, so make/unmake only
+    subtract and add those columns (BasicPosition::update_lines); the output
+    layer runs once per evaluation. The score is O-positive in the units of
+    the pattern table. Fives are still scored by the pattern table.
+
+    Kernels: AVX2 (unaligned loads: the data is only 16-byte aligned) or SSE2
+    on x86 hosts, plain C on the device; -DNNUE_SCALAR forces plain C
+    everywhere. -DNNUE_PIE opts the ESP32-S3 into column updates with the
+    128-bit PIE instructions (EE.VADDS.S16 / EE.VSUBS.S16, 8 lanes). It is off
+    by default until it has been checked against plain C on hardware. The
+    trainer keeps |acc| far from the int16 limit, so the saturating PIE adds
+    should give the same sums as the wrapping ones elsewhere.
+
+    The weights come from a blob written by tools/train_nnue.cpp (a file on
+    Linux, the flash partition on the device) and are copied into an aligned
+    NnueNet by load():
+
+        NnueHeader, int16 l1_bias[H], int16 l1_weights[F][H], int8 out_weights[H]
+*/
+#pragma once
+
+#include <string.h>
+#include "caro_bitboard.h"
+
+#if defined(NNUE_SCALAR)
+#undef NNUE_PIE
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NNUE_SSE2 1
+#elif defined(NNUE_PIE) && !(defined(ESP_PLATFORM) && defined(CONFIG_IDF_TARGET_ESP32S3))
+#error "NNUE_PIE needs the ESP32-S3"
+#endif
+
+#define NNUE_MAGIC    0x314E4E43u // "CNN1"
+#define NNUE_FEATURES (2 * 31)    // X windows, then O windows, by 5-bit mask - 1
+#define NNUE_HIDDEN   32
+#define NNUE_QA       127         // acc units per 1.0 of activation
+#define NNUE_QB       64          // out_weights units per 1.0
+
+#define NNUE_PARTITION_OFFSET 0x100000 // Blob offset in BOOK_PARTITION, after the opening book
+
+static_assert(NNUE_HIDDEN == 32, "The vector kernels are unrolled for 32 lanes");
+
+struct NnueHeader {
+    uint32_t magic;
+    uint16_t features; // NNUE_FEATURES
+    uint16_t hidden;   // NNUE_HIDDEN
+    int32_t out_bias;  // In hidden * out_weights units
+    int32_t out_mul;   // Score per output unit, 16.16 fixed point
+};
+
+// Stones added or removed keep acc exact: only integer column sums
+struct NnueAccumulator {
+    alignas(16) int16_t v[NNUE_HIDDEN];
+};
+
+#if defined(NNUE_PIE)
+// 4 x (load acc, load column, saturating op, store acc)
+#define NNUE_PIE_STEP(op)                   \
+    "ee.vld.128.ip q0, %0, 16\n"            \
+    "ee.vld.128.ip q1, %2, 16\n"            \
+    op " q0, q0, q1\n"                      \
+    "ee.vst.128.ip q0, %1, 16\n"
+#define NNUE_PIE_COLUMN(op)                                                            \
+    int16_t* in = acc;                                                                 \
+    int16_t* out = acc;                                                                \
+    const int16_t* c = col;                                                            \
+    asm volatile(NNUE_PIE_STEP(op) NNUE_PIE_STEP(op) NNUE_PIE_STEP(op) NNUE_PIE_STEP(op) \
+                 : "+r"(in), "+r"(out), "+r"(c) : : "memory")
+#endif
+
+static inline void nnue_add(int16_t* acc, const int16_t* col) {
+#if defined(NNUE_AVX2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+        _mm256_storeu_si256((__m256i*)(acc + i), _mm256_add_epi16(a, _mm256_loadu_si256((const __m256i*)(col + i))));
+    }
+#elif defined(NNUE_SSE2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i a = _mm_load_si128((const __m128i*)(acc + i));
+        _mm_store_si128((__m128i*)(acc + i), _mm_add_epi16(a, _mm_load_si128((const __m128i*)(col + i))));
+    }
+#elif defined(NNUE_PIE)
+    NNUE_PIE_COLUMN("ee.vadds.s16");
+#else
+    for (int i = 0; i < NNUE_HIDDEN; i++) acc[i] = (int16_t)(acc[i] + col[i]);
+#endif
+}
+
+static inline void nnue_sub(int16_t* acc, const int16_t* col) {
+#if defined(NNUE_AVX2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+        _mm256_storeu_si256((__m256i*)(acc + i), _mm256_sub_epi16(a, _mm256_loadu_si256((const __m256i*)(col + i))));
+    }
+#elif defined(NNUE_SSE2)
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i a = _mm_load_si128((const __m128i*)(acc + i));
+        _mm_store_si128((__m128i*)(acc + i), _mm_sub_epi16(a, _mm_load_si128((const __m128i*)(col + i))));
+    }
+#elif defined(NNUE_PIE)
+    NNUE_PIE_COLUMN("ee.vsubs.s16");
+#else
+    for (int i = 0; i < NNUE_HIDDEN; i++) acc[i] = (int16_t)(acc[i] - col[i]);
+#endif
+}
+
+// sum of clamp(acc, 0, NNUE_QA) * w
+static inline int32_t nnue_dot(const int16_t* acc, const int16_t* w) {
+#if defined(NNUE_AVX2)
+    const __m256i lo = _mm256_setzero_si256(), hi = _mm256_set1_epi16(NNUE_QA);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i a = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i*)(acc + i)), lo), hi);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, _mm256_loadu_si256((const __m256i*)(w + i))));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+#elif defined(NNUE_SSE2)
+    const __m128i lo = _mm_setzero_si128(), hi = _mm_set1_epi16(NNUE_QA);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i a = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i*)(acc + i)), lo), hi);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(a, _mm_load_si128((const __m128i*)(w + i))));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int a = acc[i] < 0 ? 0 : acc[i] > NNUE_QA ? NNUE_QA : acc[i];
+        sum += a * w[i];
+    }
+    return sum;
+#endif
+}
+
+// Feature of a window from both players' 5-bit masks, -1 for an empty or mixed window
+static inline int nnue_window_feature(unsigned x, unsigned o) {
+    if (x && !o) return (int)x - 1;
+    if (o && !x) return NNUE_FEATURES / 2 + (int)o - 1;
+    return -1;
+}
+
+struct NnueNet {
+    alignas(16) int16_t l1_bias[NNUE_HIDDEN];
+    alignas(16) int16_t l1_weights[NNUE_FEATURES][NNUE_HIDDEN];
+    alignas(16) int16_t out_weights[NNUE_HIDDEN]; // int8 in the blob, widened for the dot kernels
+    int32_t out_bias;
+    int32_t out_mul;
+
+    // Checks the header and size and copies the weights; the blob may be unmapped afterwards
+    bool load(const void* data, size_t size) {
+        NnueHeader h;
+        const size_t body = sizeof(l1_bias) + sizeof(l1_weights) + NNUE_HIDDEN;
+        if (!data || size < sizeof(h) + body) return false;
+        memcpy(&h, data, sizeof(h));
+        if (h.magic != NNUE_MAGIC || h.features != NNUE_FEATURES || h.hidden != NNUE_HIDDEN) return false;
+
+        const uint8_t* p = (const uint8_t*)data + sizeof(h);
+        memcpy(l1_bias, p, sizeof(l1_bias));
+        p += sizeof(l1_bias);
+        memcpy(l1_weights, p, sizeof(l1_weights));
+        p += sizeof(l1_weights);
+        for (int i = 0; i < NNUE_HIDDEN; i++) out_weights[i] = (int8_t)p[i];
+        out_bias = h.out_bias;
+        out_mul = h.out_mul;
+        return true;
+    }
+
+    // O-positive score of the position whose accumulator is acc
+    int evaluate(const NnueAccumulator& acc) const {
+        int64_t out = (int64_t)out_bias + nnue_dot(acc.v, out_weights);
+        return (int)((out * out_mul) >> 16);
+    }
+
+    void reset(NnueAccumulator& acc) const { memcpy(acc.v, l1_bias, sizeof(acc.v)); }
+
+    // Moves acc from a line holding (x0, o0) to the same line holding (x1, o1), which differ
+    // in the cell at pos only: just the windows through pos change.
+    void update_line(NnueAccumulator& acc, unsigned x0, unsigned o0, unsigned x1, unsigned o1, int pos, int len) const {
+        int lo = (pos >= WIN_COUNT - 1) ? pos - (WIN_COUNT - 1) : 0;
+        int hi = (pos <= len - WIN_COUNT) ? pos : len - WIN_COUNT;
+        for (int s = lo; s <= hi; s++) {
+            int f0 = nnue_window_feature((x0 >> s) & 0x1F, (o0 >> s) & 0x1F);
+            int f1 = nnue_window_feature((x1 >> s) & 0x1F, (o1 >> s) & 0x1F);
+            if (f0 == f1) continue;
+            if (f0 >= 0) nnue_sub(acc.v, l1_weights[f0]);
+            if (f1 >= 0) nnue_add(acc.v, l1_weights[f1]);
+        }
+    }
+
+    // Adds every live window of a line of len cells
+    void add_line(NnueAccumulator& acc, unsigned x, unsigned o, int len) const {
+        for (int s = 0; s + WIN_COUNT <= len; s++) {
+            int f = nnue_window_feature((x >> s) & 0x1F, (o >> s) & 0x1F);
+            if (f >= 0) nnue_add(acc.v, l1_weights[f]);
+        }
+    }
+};
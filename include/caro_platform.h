@@ -0,0 +1,346 @@
+/*
+    Thin platform layer so the engine headers build both on the ESP32-S3
+    (Arduino / ESP-IDF) and on a Linux host.
+
+    Threads are FreeRTOS tasks on the device (optionally pinned to a core) and
+    pthreads on Linux. caro_thread_join() waits for the function to return.
+    A CaroWorker is a thread started once and run any number of times:
+    caro_worker_run() wakes it to call its function again, caro_worker_wait()
+    waits for that call to return, and caro_worker_stop() ends the thread.
+    Searches that run every move keep their helpers this way instead of
+    creating a task (and its stack) per search.
+
+    caro_map_readonly() maps read-only data into memory without copying it: a
+    flash data partition (by label) on the device, a file (by path) on Linux.
+
+    Building with -DCARO_ALLOC_CHECK counts operator new calls per thread, and
+    a CaroNoAllocScope aborts if its thread allocated while it was alive.
+    Search::think() holds one, so any program built with the flag (the sketch,
+    the tools/ benchmarks) fails at the first search that touches the heap.
+    malloc() and heap_caps_malloc() are not seen. The replacement operators
+    live in this header, so only single translation unit programs may use it.
+
+    CancelToken / CancelCheck: cooperative cancellation. The owner bumps the
+    token's generation; every search started under an older generation sees
+    itself cancelled the next time it polls, and whoever collects its result
+    can tell the result is stale the same way.
+
+    Building with -DCARO_PROFILE makes CARO_PROFILE_SCOPE(total) add the CPU
+    cycles (caro_cycles()) spent in the enclosing block to total; without it
+    the macro compiles to nothing. Cycles, not microseconds: the clock costs
+    more than the evaluation it would time.
+*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#if defined(ESP_PLATFORM)
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "xtensa/hal.h"
+
+// Helper searches: the recursion lives on it. Sized like the sketch's AI worker: 12.3 KB peak
+// measured on the host, with room for Xtensa's larger register-window frames.
+#define CARO_THREAD_STACK 20480
+
+// Large engine tables go to PSRAM (board_build.psram = enabled), never internal RAM.
+static inline void* caro_alloc_large(size_t size) {
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static inline void caro_free_large(void* p) { heap_caps_free(p); }
+
+static inline int64_t caro_now_us() { return esp_timer_get_time(); }
+
+// Lets same-priority tasks (LVGL) run between root moves of a long search
+static inline void caro_yield() { vTaskDelay(1); }
+
+// Cycle counter of the calling core; 32 bits, so it wraps every few seconds
+static inline uint64_t caro_cycles() { return xthal_get_ccount(); }
+
+struct CaroThread {
+    void (*fn)(void*);
+    void* arg;
+    SemaphoreHandle_t done;
+};
+
+static void caro_thread_entry(void* p) {
+    CaroThread* t = (CaroThread*)p;
+    t->fn(t->arg);
+    xSemaphoreGive(t->done);
+    vTaskDelete(NULL);
+}
+
+// core = -1 lets the scheduler pick
+static inline bool caro_thread_start(CaroThread& t, void (*fn)(void*), void* arg, int core) {
+    t.fn = fn;
+    t.arg = arg;
+    t.done = xSemaphoreCreateBinary();
+    if (!t.done) return false;
+    BaseType_t ok = xTaskCreatePinnedToCore(caro_thread_entry, "AI_Helper", CARO_THREAD_STACK, &t, 1, NULL,
+                                            core < 0 ? tskNO_AFFINITY : core);
+    if (ok != pdPASS) {
+        vSemaphoreDelete(t.done);
+        return false;
+    }
+    return true;
+}
+
+static inline void caro_thread_join(CaroThread& t) {
+    xSemaphoreTake(t.done, portMAX_DELAY);
+    vSemaphoreDelete(t.done);
+}
+
+struct CaroWorker {
+    void (*fn)(void*);
+    void* arg;
+    bool started = false;
+    bool quit = false;
+    SemaphoreHandle_t go;
+    SemaphoreHandle_t done;
+};
+
+static void caro_worker_entry(void* p) {
+    CaroWorker* w = (CaroWorker*)p;
+    for (;;) {
+        xSemaphoreTake(w->go, portMAX_DELAY);
+        if (w->quit) break;
+        w->fn(w->arg);
+        xSemaphoreGive(w->done);
+    }
+    xSemaphoreGive(w->done);
+    vTaskDelete(NULL);
+}
+
+// core = -1 lets the scheduler pick
+static inline bool caro_worker_start(CaroWorker& w, void (*fn)(void*), void* arg, int core) {
+    w.fn = fn;
+    w.arg = arg;
+    w.quit = false;
+    w.go = xSemaphoreCreateBinary();
+    w.done = xSemaphoreCreateBinary();
+    if (w.go && w.done &&
+        xTaskCreatePinnedToCore(caro_worker_entry, "AI_Helper", CARO_THREAD_STACK, &w, 1, NULL,
+                                core < 0 ? tskNO_AFFINITY : core) == pdPASS) {
+        w.started = true;
+        return true;
+    }
+    if (w.go) vSemaphoreDelete(w.go);
+    if (w.done) vSemaphoreDelete(w.done);
+    return false;
+}
+
+static inline void caro_worker_run(CaroWorker& w) { xSemaphoreGive(w.go); }
+static inline void caro_worker_wait(CaroWorker& w) { xSemaphoreTake(w.done, portMAX_DELAY); }
+
+// Waits for the thread to end; only between runs
+static inline void caro_worker_stop(CaroWorker& w) {
+    if (!w.started) return;
+    w.quit = true;
+    xSemaphoreGive(w.go);
+    xSemaphoreTake(w.done, portMAX_DELAY);
+    vSemaphoreDelete(w.go);
+    vSemaphoreDelete(w.done);
+    w.started = false;
+}
+
+// Maps a whole data partition through the flash cache. Stays mapped until reboot.
+static inline const void* caro_map_readonly(const char* name, size_t* size) {
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+    if (!part) return nullptr;
+    const void* ptr = nullptr;
+    spi_flash_mmap_handle_t handle;
+    if (esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK) return nullptr;
+    *size = part->size;
+    return ptr;
+}
+
+#else
+#include <stdlib.h>
+#include <chrono>
+#include <pthread.h>
+#include <semaphore.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static inline void* caro_alloc_large(size_t size) { return malloc(size); }
+static inline void caro_free_large(void* p) { free(p); }
+
+static inline int64_t caro_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void caro_yield() {}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t caro_cycles() { return __rdtsc(); }
+#else
+static inline uint64_t caro_cycles() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+struct CaroThread {
+    void (*fn)(void*);
+    void* arg;
+    pthread_t handle;
+};
+
+static void* caro_thread_entry(void* p) {
+    CaroThread* t = (CaroThread*)p;
+    t->fn(t->arg);
+    return nullptr;
+}
+
+// Cores are left to the OS on Linux
+static inline bool caro_thread_start(CaroThread& t, void (*fn)(void*), void* arg, int core) {
+    (void)core;
+    t.fn = fn;
+    t.arg = arg;
+    return pthread_create(&t.handle, nullptr, caro_thread_entry, &t) == 0;
+}
+
+static inline void caro_thread_join(CaroThread& t) { pthread_join(t.handle, nullptr); }
+
+struct CaroWorker {
+    void (*fn)(void*);
+    void* arg;
+    bool started = false;
+    bool quit = false;
+    sem_t go;
+    sem_t done;
+    pthread_t handle;
+};
+
+static void* caro_worker_entry(void* p) {
+    CaroWorker* w = (CaroWorker*)p;
+    for (;;) {
+        sem_wait(&w->go);
+        if (w->quit) break;
+        w->fn(w->arg);
+        sem_post(&w->done);
+    }
+    return nullptr;
+}
+
+static inline bool caro_worker_start(CaroWorker& w, void (*fn)(void*), void* arg, int core) {
+    (void)core;
+    w.fn = fn;
+    w.arg = arg;
+    w.quit = false;
+    sem_init(&w.go, 0, 0);
+    sem_init(&w.done, 0, 0);
+    if (pthread_create(&w.handle, nullptr, caro_worker_entry, &w) != 0) {
+        sem_destroy(&w.go);
+        sem_destroy(&w.done);
+        return false;
+    }
+    w.started = true;
+    return true;
+}
+
+static inline void caro_worker_run(CaroWorker& w) { sem_post(&w.go); }
+
+static inline void caro_worker_wait(CaroWorker& w) {
+    while (sem_wait(&w.done) != 0) {} // Retried after a signal
+}
+
+static inline void caro_worker_stop(CaroWorker& w) {
+    if (!w.started) return;
+    w.quit = true;
+    sem_post(&w.go);
+    pthread_join(w.handle, nullptr);
+    sem_destroy(&w.go);
+    sem_destroy(&w.done);
+    w.started = false;
+}
+
+// Maps a whole file. Stays mapped until the process exits.
+static inline const void* caro_map_readonly(const char* name, size_t* size) {
+    int fd = open(name, O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    void* ptr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) return nullptr;
+    *size = (size_t)st.st_size;
+    return ptr;
+}
+
+#endif
+
+struct CancelToken {
+    std::atomic<uint32_t> generation{0};
+
+    void cancel() { generation.fetch_add(1, std::memory_order_relaxed); }
+    uint32_t current() const { return generation.load(std::memory_order_relaxed); }
+};
+
+// A search's view of a token: cancelled once the generation has moved on. The default never is.
+struct CancelCheck {
+    const CancelToken* token = nullptr;
+    uint32_t generation = 0;
+
+    bool cancelled() const { return token && token->current() != generation; }
+};
+
+#if defined(CARO_ALLOC_CHECK)
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+inline thread_local uint32_t caro_alloc_count = 0;
+
+void* operator new(size_t size) {
+    caro_alloc_count++;
+    void* p = malloc(size ? size : 1);
+    if (!p) abort();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+struct CaroNoAllocScope {
+    const char* what;
+    uint32_t start = caro_alloc_count;
+
+    explicit CaroNoAllocScope(const char* name) : what(name) {}
+    ~CaroNoAllocScope() {
+        if (caro_alloc_count == start) return;
+        fprintf(stderr, "%s: %u heap allocations\n", what, (unsigned)(caro_alloc_count - start));
+        abort();
+    }
+};
+#else
+struct CaroNoAllocScope {
+    explicit CaroNoAllocScope(const char*) {}
+};
+#endif
+
+#if defined(CARO_PROFILE)
+struct CaroProfileScope {
+    uint64_t& total;
+    uint64_t start = caro_cycles();
+
+    explicit CaroProfileScope(uint64_t& t) : total(t) {}
+    ~CaroProfileScope() { total += (uint32_t)(caro_cycles() - start); } // Short scopes: survives the ESP32's 32-bit counter wrapping
+};
+#define CARO_PROFILE_SCOPE(total) CaroProfileScope caro_profile_scope(total)
+#else
+#define CARO_PROFILE_SCOPE(total) ((void)0)
+#endif
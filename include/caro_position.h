@@ -0,0 +1,336 @@
+/*
+    Search position with make/unmake and an incrementally updated score.
+
+    Every run of stones lies on exactly one row, column or diagonal, so the
+    board score is the sum of independent per-line scores. Each line keeps its
+    stones as small bit masks (one per player) plus its cached score; a move
+    only rescores the 4 lines through its cell.
+
+    A line is scored from table lookups. For one player, the opponent's stones
+    and the board edge cut the line into segments; inside a segment only that
+    player's own-stone mask matters, so PATTERNS holds the shape of every
+    (segment length, own mask) pair, 2047 entries built at compile time.
+    Shapes are classified by what one more stone makes, so gapped shapes such
+    as X_XX or XX_XX score like the runs they threaten to become.
+
+    A shape's score comes from the position's EvalWeights, by default the
+    table in caro_weights.h that tools/tune_eval.cpp fits from self-play.
+    The score is linear in the weights, which is what the tuner relies on.
+
+    The tables follow the rule set (caro_rules.h): one per kind of five (exact
+    or not), and under caro rules one page per combination of segment ends that
+    are opponent stones rather than the board edge, since a five squeezed
+    between two opponent stones does not win there.
+
+    With a net set (set_net()), make/unmake also keep an NNUE accumulator
+    (caro_nnue.h) in step, and nnue_score() evaluates it. score stays the
+    pattern-table sum either way, since it is what tells a five on the board.
+*/
+#pragma once
+
+#include "caro_rules.h"
+#include "caro_weights.h"
+#include "caro_nnue.h"
+
+// Điểm số đánh giá
+#define SCORE_WIN       1000000
+
+#define LINE_COUNT (2 * BOARD_SIZE - 1) // Longest set: 19 diagonals per direction
+
+// Zobrist keys, one per (player, square), generated at compile time with splitmix64.
+struct ZobristKeys {
+    uint64_t stone[2][BB_CELLS];
+    uint64_t side; // XOR-ed in when X is to move
+
+    constexpr ZobristKeys() : stone(), side(0) {
+        uint64_t seed = 0x2545F4914F6CDD1DULL;
+        for (int p = 0; p < 2; p++)
+            for (int sq = 0; sq < BB_CELLS; sq++) stone[p][sq] = next(seed);
+        side = next(seed);
+    }
+
+    static constexpr uint64_t next(uint64_t& seed) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+static constexpr ZobristKeys ZOBRIST{};
+
+// Shapes inside one segment, weakest first
+enum SegmentShape { SHAPE_NONE, SHAPE_OPEN_2, SHAPE_BLOCKED_3, SHAPE_OPEN_3, SHAPE_BLOCKED_4, SHAPE_OPEN_4, SHAPE_FIVE, SHAPE_COUNT };
+
+// Score of each SegmentShape for the player who owns it
+struct EvalWeights {
+    int32_t shape[SHAPE_COUNT];
+};
+
+// Tuned weights up to the open four; a five is always SCORE_WIN, which the search treats as won
+static constexpr EvalWeights DEFAULT_WEIGHTS = { { 0, EVAL_WEIGHTS[1], EVAL_WEIGHTS[2], EVAL_WEIGHTS[3],
+                                                   EVAL_WEIGHTS[4], EVAL_WEIGHTS[5], SCORE_WIN } };
+
+// Five-in-a-segment tests for one kind of five. Exact: a run longer than five does not
+// count. BlockedWins false: a five filling the whole segment does not count when both
+// segment ends are opponent stones (ends bit 0 = left, bit 1 = right).
+template <bool Exact, bool BlockedWins>
+struct SegmentRules {
+    // Does the full window at s count as a five?
+    static constexpr bool five_counts(unsigned own, int len, int ends, int s) {
+        if (Exact && ((s > 0 && ((own >> (s - 1)) & 1)) || (s + WIN_COUNT < len && ((own >> (s + WIN_COUNT)) & 1)))) return false;
+        if (!BlockedWins && s == 0 && s + WIN_COUNT == len && ends == 3) return false;
+        return true;
+    }
+
+    // Empty cells of a segment of `len` cells where one more stone completes five
+    static constexpr int five_cells(unsigned own, int len, int ends) {
+        unsigned cells = 0;
+        for (int s = 0; s + WIN_COUNT <= len; s++) {
+            unsigned w = (own >> s) & ((1u << WIN_COUNT) - 1);
+            if (__builtin_popcount(w) != WIN_COUNT - 1) continue;
+            unsigned cell = (~w & ((1u << WIN_COUNT) - 1)) << s;
+            if (five_counts(own | cell, len, ends, s)) cells |= cell;
+        }
+        return __builtin_popcount(cells);
+    }
+
+    static constexpr bool has_five(unsigned own, int len, int ends) {
+        for (int s = 0; s + WIN_COUNT <= len; s++) {
+            if (((own >> s) & ((1u << WIN_COUNT) - 1)) == (1u << WIN_COUNT) - 1 && five_counts(own, len, ends, s)) return true;
+        }
+        return false;
+    }
+
+    // Five; two cells to complete five (open four, or X_XXX_X) / one cell; otherwise the best
+    // shape one more stone reaches, one step down: an open four makes an open three, a four
+    // a blocked three, an open three an open two.
+    static constexpr int shape(unsigned own, int len, int ends, int moves_left) {
+        if (has_five(own, len, ends)) return SHAPE_FIVE;
+        int fives = five_cells(own, len, ends);
+        if (fives >= 2) return SHAPE_OPEN_4;
+        if (fives == 1) return SHAPE_BLOCKED_4;
+        if (moves_left == 0 || __builtin_popcount(own) < 2) return SHAPE_NONE;
+
+        int best = SHAPE_NONE;
+        for (int e = 0; e < len; e++) {
+            if ((own >> e) & 1) continue;
+            int next = shape(own | (1u << e), len, ends, moves_left - 1);
+            int s = (next == SHAPE_OPEN_4) ? SHAPE_OPEN_3 : (next == SHAPE_BLOCKED_4) ? SHAPE_BLOCKED_3 :
+                    (next == SHAPE_OPEN_3) ? SHAPE_OPEN_2 : SHAPE_NONE;
+            if (s > best) best = s;
+        }
+        return best;
+    }
+};
+
+// PATTERNS<...>.shape[page][(1 << len) | own]: SegmentShape of a segment of len cells (len <= BOARD_SIZE).
+// Segments shorter than five cells can never hold a five and are SHAPE_NONE. Only caro rules
+// need more than one page (see SegmentRules); the page is the segment's ends bits.
+template <bool Exact, bool BlockedWins>
+struct PatternTable {
+    static constexpr int PAGES = BlockedWins ? 1 : 4;
+    uint8_t shape[PAGES][2 << BOARD_SIZE];
+
+    constexpr PatternTable() : shape() {
+        for (int page = 0; page < PAGES; page++) {
+            for (int len = WIN_COUNT; len <= BOARD_SIZE; len++) {
+                for (unsigned own = 0; own < (1u << len); own++) {
+                    shape[page][(1u << len) | own] = (uint8_t)SegmentRules<Exact, BlockedWins>::shape(own, len, page, 2);
+                }
+            }
+        }
+    }
+};
+
+template <bool Exact, bool BlockedWins>
+static constexpr PatternTable<Exact, BlockedWins> PATTERNS{};
+
+// Positive score of `own` on one line of `len` cells whose other stones are `blocked`
+template <bool Exact, bool BlockedWins>
+static inline int evaluate_line_player(unsigned own, unsigned blocked, int len, const EvalWeights& w) {
+    int score = 0;
+    unsigned walls = blocked | (1u << len);
+    int start = 0;
+    while (start < len) {
+        int end = start + __builtin_ctz(walls >> start);
+        int seg = end - start;
+        if (seg >= WIN_COUNT) {
+            int page = 0;
+            if constexpr (!BlockedWins) page = (start > 0) | ((end < len) << 1);
+            score += w.shape[PATTERNS<Exact, BlockedWins>.shape[page][(1u << seg) | ((own >> start) & ((1u << seg) - 1))]];
+        }
+        start = end + 1;
+    }
+    return score;
+}
+
+// O-positive score of one line
+template <class Rules>
+static inline int evaluate_line_bits(unsigned x_bits, unsigned o_bits, int len, const EvalWeights& w) {
+    return evaluate_line_player<Rules::exact_five[PLAYER_O], Rules::blocked_five_wins>(o_bits, x_bits, len, w) -
+           evaluate_line_player<Rules::exact_five[PLAYER_X], Rules::blocked_five_wins>(x_bits, o_bits, len, w);
+}
+
+// Line index, position along the line and line length of (r, c) for each direction.
+// Lines are numbered by row, column, r - c + 9 and r + c; positions run in the
+// same direction as BB_DIR_SHIFT.
+static inline void line_coords(int dir, int r, int c, int& line, int& pos, int& len) {
+    switch (dir) {
+        case 0: line = r; pos = c; len = BOARD_SIZE; break;
+        case 1: line = c; pos = r; len = BOARD_SIZE; break;
+        case 2:
+            line = r - c + BOARD_SIZE - 1;
+            pos = (r < c) ? r : c;
+            len = BOARD_SIZE - ((r > c) ? r - c : c - r);
+            break;
+        default:
+            line = r + c;
+            pos = (line < BOARD_SIZE) ? r : BOARD_SIZE - 1 - c;
+            len = (line < BOARD_SIZE) ? line + 1 : 2 * BOARD_SIZE - 1 - line;
+            break;
+    }
+}
+
+// Number of lines and length of line `line` in direction dir, numbered as in line_coords
+static inline int line_count(int dir) { return (dir < 2) ? BOARD_SIZE : LINE_COUNT; }
+static inline int line_length(int dir, int line) {
+    if (dir < 2) return BOARD_SIZE;
+    int off = line - (BOARD_SIZE - 1); // Both diagonal sets peak at the middle line
+    return BOARD_SIZE - ((off < 0) ? -off : off);
+}
+
+// Strongest straight shape a stone on an empty cell would make, used for move ordering
+enum ThreatLevel { THREAT_NONE, THREAT_OPEN_THREE, THREAT_FOUR, THREAT_OPEN_FOUR, THREAT_FIVE };
+
+template <class Rules>
+struct BasicPosition : BitPosition {
+    uint16_t lines[2][4][LINE_COUNT]; // Stones of each player per line, bit = position on line
+    int line_score[4][LINE_COUNT];
+    int score;                        // Same value evaluate_board_gomoku() used to rescan for
+    int stone_count;
+    uint64_t key;                     // Zobrist key of the stones (side to move not included)
+
+    // Cells within 1 / 2 king steps of any stone. Stones only come off in LIFO order,
+    // so unmake_move restores the masks saved at that stone count instead of recomputing.
+    Bitboard near[2];
+    Bitboard near_saved[BOARD_SIZE * BOARD_SIZE][2];
+
+    const EvalWeights* weights = &DEFAULT_WEIGHTS; // Kept by clear(); change it with set_weights()
+    const NnueNet* net = nullptr;                  // Same, with set_net(); nullptr = no accumulator
+    NnueAccumulator nnue;
+
+    void clear() {
+        BitPosition::clear();
+        for (int p = 0; p < 2; p++)
+            for (int d = 0; d < 4; d++)
+                for (int i = 0; i < LINE_COUNT; i++) lines[p][d][i] = 0;
+        for (int d = 0; d < 4; d++)
+            for (int i = 0; i < LINE_COUNT; i++) line_score[d][i] = 0;
+        score = 0;
+        stone_count = 0;
+        key = 0;
+        near[0] = near[1] = { 0, 0 };
+        if (net) net->reset(nnue);
+    }
+
+    // Scores the stones on the board with w from now on
+    void set_weights(const EvalWeights* w) {
+        weights = w;
+        score = 0;
+        for (int d = 0; d < 4; d++) {
+            for (int i = 0; i < line_count(d); i++) {
+                line_score[d][i] = evaluate_line_bits<Rules>(lines[PLAYER_X][d][i], lines[PLAYER_O][d][i], line_length(d, i), *weights);
+                score += line_score[d][i];
+            }
+        }
+    }
+
+    // Keeps an accumulator for n (nullptr = none) from now on
+    void set_net(const NnueNet* n) {
+        net = n;
+        if (!net) return;
+        net->reset(nnue);
+        for (int d = 0; d < 4; d++) {
+            for (int i = 0; i < line_count(d); i++) net->add_line(nnue, lines[PLAYER_X][d][i], lines[PLAYER_O][d][i], line_length(d, i));
+        }
+    }
+
+    // O-positive net score, kept clear of the win scores; needs a net
+    int nnue_score() const {
+        int s = net->evaluate(nnue);
+        return (s > SCORE_WIN / 4) ? SCORE_WIN / 4 : (s < -SCORE_WIN / 4) ? -SCORE_WIN / 4 : s;
+    }
+
+    // Empty cells within `range` (1 or 2) of a stone: the move generator's candidate set
+    Bitboard candidates(int range) const { return near[range - 1] & empty(); }
+
+    void make_move(int sq, int player) {
+        bb_set(stones[player], sq);
+        near_saved[stone_count][0] = near[0];
+        near_saved[stone_count][1] = near[1];
+        near[0] = near[0] | BB_NEAR.mask[0][sq];
+        near[1] = near[1] | BB_NEAR.mask[1][sq];
+        stone_count++;
+        key ^= ZOBRIST.stone[player][sq];
+        update_lines(sq, player, true);
+    }
+
+    void unmake_move(int sq, int player) {
+        bb_clear(stones[player], sq);
+        stone_count--;
+        near[0] = near_saved[stone_count][0];
+        near[1] = near_saved[stone_count][1];
+        key ^= ZOBRIST.stone[player][sq];
+        update_lines(sq, player, false);
+    }
+
+    // ThreatLevel of `player` playing the empty cell sq (unbroken runs only)
+    int threat_at(int sq, int player) const {
+        int r = bb_row(sq), c = bb_col(sq);
+        int best = THREAT_NONE;
+        for (int dir = 0; dir < 4; dir++) {
+            int line, pos, len;
+            line_coords(dir, r, c, line, pos, len);
+            unsigned own = lines[player][dir][line] | (1u << pos);
+            unsigned other = lines[player ^ 1][dir][line];
+
+            int lo = pos, hi = pos;
+            while (lo > 0 && ((own >> (lo - 1)) & 1)) lo--;
+            while (hi < len - 1 && ((own >> (hi + 1)) & 1)) hi++;
+            int count = hi - lo + 1;
+            if (count == WIN_COUNT || (count > WIN_COUNT && !Rules::exact_five[player])) return THREAT_FIVE;
+
+            int open = (lo > 0 && !((other >> (lo - 1)) & 1)) + (hi < len - 1 && !((other >> (hi + 1)) & 1));
+            int level = THREAT_NONE;
+            if (count == 4) level = (open == 2) ? THREAT_OPEN_FOUR : (open == 1) ? THREAT_FOUR : THREAT_NONE;
+            else if (count == 3 && open == 2) level = THREAT_OPEN_THREE;
+            if (level > best) best = level;
+        }
+        return best;
+    }
+
+private:
+    void update_lines(int sq, int player, bool add) {
+        int r = bb_row(sq), c = bb_col(sq);
+        for (int dir = 0; dir < 4; dir++) {
+            int line, pos, len;
+            line_coords(dir, r, c, line, pos, len);
+            unsigned before = lines[player][dir][line];
+            if (add) lines[player][dir][line] |= (uint16_t)(1u << pos);
+            else     lines[player][dir][line] &= (uint16_t)~(1u << pos);
+
+            if (net) {
+                unsigned other = lines[player ^ 1][dir][line], after = lines[player][dir][line];
+                if (player == PLAYER_X) net->update_line(nnue, before, other, after, other, pos, len);
+                else                    net->update_line(nnue, other, before, other, after, pos, len);
+            }
+
+            int s = evaluate_line_bits<Rules>(lines[PLAYER_X][dir][line], lines[PLAYER_O][dir][line], len, *weights);
+            score += s - line_score[dir][line];
+            line_score[dir][line] = s;
+        }
+    }
+};
+
+using Position = BasicPosition<FreestyleRules>;
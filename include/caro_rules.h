@@ -0,0 +1,197 @@
+/*
+    Rule sets. Each one is a struct of compile-time flags; the position,
+    evaluator, threat search, search and MCTS are templates over it, so every
+    rule set gets its own compiled engine and no hot loop tests the rules at
+    run time (if constexpr drops what a rule set does not need).
+
+    FreestyleRules  five or more in a row wins
+    ExactFiveRules  exactly five wins; six or more does not
+    CaroRules       Vietnamese caro: five or more wins unless the five has an
+                    opponent stone at both ends (the board edge does not block)
+    RenjuRules      X is black and always starts: it wins only with exactly five
+                    and may not play a double three, a double four or an overline
+                    (unless the move makes five). O wins with five or more.
+
+    Forbidden moves are found with the same windows as the threat search: a four
+    is a 5-cell window with 4 stones and 1 empty cell, a three a 6-cell window
+    _XXX?_ that one more stone turns into a straight four. Fours on one line are
+    told apart by their stones, so X_XXX_X is a double four and _XXXX_ a single
+    one. Renju's finer points (a three whose four would itself be forbidden is
+    not a three) are not modelled.
+
+    Fours and fives follow the rules exactly; open threes (bb_three_cells,
+    bb_three_defences) are the freestyle shapes under every rule set, they only
+    steer the search and the threat solver.
+*/
+#pragma once
+
+#include "caro_bitboard.h"
+
+enum RuleSet { RULES_FREESTYLE, RULES_EXACT_FIVE, RULES_CARO, RULES_RENJU, RULES_COUNT };
+
+static const char* const RULE_NAMES[RULES_COUNT] = { "Freestyle", "Exact five", "Caro", "Renju" };
+
+struct FreestyleRules {
+    static constexpr RuleSet id = RULES_FREESTYLE;
+    static constexpr bool exact_five[2] = { false, false }; // [player]: six or more in a row does not win
+    static constexpr bool blocked_five_wins = true;         // A five with opponent stones at both ends still wins
+    static constexpr bool black_restricted = false;         // Renju restrictions on X
+};
+
+struct ExactFiveRules {
+    static constexpr RuleSet id = RULES_EXACT_FIVE;
+    static constexpr bool exact_five[2] = { true, true };
+    static constexpr bool blocked_five_wins = true;
+    static constexpr bool black_restricted = false;
+};
+
+struct CaroRules {
+    static constexpr RuleSet id = RULES_CARO;
+    static constexpr bool exact_five[2] = { false, false };
+    static constexpr bool blocked_five_wins = false;
+    static constexpr bool black_restricted = false;
+};
+
+struct RenjuRules {
+    static constexpr RuleSet id = RULES_RENJU;
+    static constexpr bool exact_five[2] = { true, false };
+    static constexpr bool blocked_five_wins = true;
+    static constexpr bool black_restricted = true;
+};
+
+// Drops the starts of 5-cell windows along `shift` that would not win for `player` once full:
+// an own stone right outside the window (overline) or, in caro, opponent stones on both sides.
+template <class Rules>
+static inline Bitboard rule_five_filter(Bitboard w, Bitboard own, Bitboard opp, int shift, int player) {
+    if constexpr (Rules::exact_five[0] || Rules::exact_five[1]) {
+        if (Rules::exact_five[player]) w = w & ~bb_shl(own, shift) & ~bb_shr(own, WIN_COUNT * shift);
+    }
+    if constexpr (!Rules::blocked_five_wins) {
+        w = w & ~(bb_shl(opp, shift) & bb_shr(opp, WIN_COUNT * shift));
+    }
+    return w;
+}
+
+// Starts of winning fives of `player` along direction dir
+template <class Rules>
+static inline Bitboard rule_five_starts(Bitboard own, Bitboard opp, int dir, int player) {
+    int s = BB_DIR_SHIFT[dir];
+    return rule_five_filter<Rules>(bb_runs(own, s, WIN_COUNT), own, opp, s, player);
+}
+
+template <class Rules>
+static inline bool rule_has_five(Bitboard own, Bitboard opp, int player) {
+    for (int d = 0; d < 4; d++) {
+        if (bb_any(rule_five_starts<Rules>(own, opp, d, player))) return true;
+    }
+    return false;
+}
+
+// Empty cells where `player` makes a winning five
+template <class Rules>
+static inline Bitboard rule_five_cells(Bitboard own, Bitboard opp, Bitboard empty, int player) {
+    if constexpr (Rules::id == RULES_FREESTYLE) {
+        return bb_five_cells(own, empty);
+    } else {
+        Bitboard cells = { 0, 0 };
+        for (int d = 0; d < 4; d++) {
+            int s = BB_DIR_SHIFT[d];
+            for (int k = 0; k < WIN_COUNT; k++) {
+                Bitboard w = bb_window(own, empty, s, WIN_COUNT, 0x1Fu & ~(1u << k));
+                if (bb_any(w)) w = rule_five_filter<Rules>(w, own, opp, s, player);
+                if (bb_any(w)) cells = cells | bb_window_cell(w, s, k);
+            }
+        }
+        return cells;
+    }
+}
+
+// Empty cells where a stone of `player` makes a four that can become a winning five
+template <class Rules>
+static inline Bitboard rule_four_cells(Bitboard own, Bitboard opp, Bitboard empty, int player) {
+    if constexpr (Rules::id == RULES_FREESTYLE) {
+        return bb_four_cells(own, empty);
+    } else {
+        Bitboard cells = { 0, 0 };
+        for (int d = 0; d < 4; d++) {
+            int s = BB_DIR_SHIFT[d];
+            for (int k1 = 0; k1 < WIN_COUNT; k1++) {
+                for (int k2 = k1 + 1; k2 < WIN_COUNT; k2++) {
+                    Bitboard w = bb_window(own, empty, s, WIN_COUNT, 0x1Fu & ~(1u << k1) & ~(1u << k2));
+                    if (bb_any(w)) w = rule_five_filter<Rules>(w, own, opp, s, player);
+                    if (bb_any(w)) cells = cells | bb_window_cell(w, s, k1) | bb_window_cell(w, s, k2);
+                }
+            }
+        }
+        return cells;
+    }
+}
+
+// True if some window start in w has a stone of the window on sq (bit j of offsets = stone at offset j)
+static inline bool bb_window_covers(Bitboard w, int sq, int shift, unsigned offsets) {
+    for (int j = 0; offsets >> j; j++) {
+        if (((offsets >> j) & 1) && sq - j * shift >= 0 && bb_test(w, sq - j * shift)) return true;
+    }
+    return false;
+}
+
+// Renju: would X playing the empty cell sq be a forbidden move?
+template <class Rules>
+static inline bool rule_forbidden(Bitboard x, Bitboard o, int sq) {
+    if constexpr (!Rules::black_restricted) {
+        return false;
+    } else {
+        Bitboard own = x | bb_from_square(sq);
+        if (rule_has_five<Rules>(own, o, PLAYER_X)) return false; // Five wins before anything else counts
+        Bitboard empty = ~(own | o) & BB_BOARD;
+
+        int fours = 0, threes = 0;
+        for (int d = 0; d < 4; d++) {
+            int s = BB_DIR_SHIFT[d];
+            if (bb_any(bb_runs(own, s, WIN_COUNT + 1))) return true; // Overline
+
+            // Fours through sq on this line, told apart by their four stones (bit 4 + offset from
+            // sq): both fives of an open four _XXXX_ use the same ones, X_XXX_X holds two fours
+            unsigned line_fours[WIN_COUNT * WIN_COUNT];
+            int count = 0;
+            for (int k = 0; k < WIN_COUNT; k++) {
+                Bitboard w = bb_window(own, empty, s, WIN_COUNT, 0x1Fu & ~(1u << k));
+                if (bb_any(w)) w = rule_five_filter<Rules>(w, own, o, s, PLAYER_X);
+                for (int j = 0; j < WIN_COUNT && bb_any(w); j++) {
+                    if (j == k || sq - j * s < 0 || !bb_test(w, sq - j * s)) continue;
+                    unsigned stones = (0x1Fu & ~(1u << k)) << (WIN_COUNT - 1 - j);
+                    bool seen = false;
+                    for (int i = 0; i < count; i++) seen |= line_fours[i] == stones;
+                    if (!seen) line_fours[count++] = stones;
+                }
+            }
+            if (count) {
+                fours += count;
+                continue;
+            }
+            for (int k = 1; k <= 4; k++) {
+                Bitboard w = bb_window(own, empty, s, 6, 0x1Eu & ~(1u << k));
+                if (bb_any(w) && bb_window_covers(w, sq, s, 0x1Eu & ~(1u << k))) {
+                    threes++;
+                    break;
+                }
+            }
+        }
+        return fours >= 2 || threes >= 2;
+    }
+}
+
+// moves without the cells `player` may not play
+template <class Rules>
+static inline Bitboard rule_legal(Bitboard moves, const Bitboard stones[2], int player) {
+    if constexpr (Rules::black_restricted) {
+        if (player == PLAYER_X) {
+            Bitboard m = moves;
+            while (bb_any(m)) {
+                int sq = bb_pop_lsb(m);
+                if (rule_forbidden<Rules>(stones[PLAYER_X], stones[PLAYER_O], sq)) bb_clear(moves, sq);
+            }
+        }
+    }
+    return moves;
+}
@@ -0,0 +1,618 @@
+/*
+    Negamax / alpha-beta search for the AI ('O').
+
+    Scores inside the tree are from the side to move's point of view; the root
+    is always O, so SearchResult::score keeps the O-positive sign of pos.score.
+    Moves after the first are searched with a null window (principal variation
+    search) and only re-searched when they beat alpha.
+
+    think() runs iterative deepening: depth 1, 2, 3 ... until max_depth or the
+    wall-clock budget runs out, and always answers with the best move of the
+    last fully completed iteration. Depth 1 is never cut short, so there is
+    always a move to play. From depth 2 on the root starts with an aspiration
+    window around the previous iteration's score and widens it on a fail.
+
+    Before that, a threat-space search (caro_threat.h) looks for a forced win
+    for O, and for a VCF the opponent could play next; in that case the root
+    is narrowed to the moves that stop it.
+
+    At the horizon a quiescence search keeps playing forcing moves only (make
+    a four or, on its first ply, an open three; block a five or an open three)
+    until the position is quiet, so a threat left hanging on the last ply is
+    not scored as if nobody could answer it. Each leaf gets its own node
+    budget (SearchLimits::quiesce_nodes) and ply limit; past those it stands
+    pat.
+
+    With SearchLimits::all_root_scores every root move is searched with a
+    full window instead, so each gets an exact score rather than a bound
+    below the best one; root_scores keeps them from the last completed
+    iteration. That is one search for a whole heat-map of hints, at the
+    price of the pruning between root moves.
+
+    Cancellation (a CancelCheck, caro_platform.h) is polled with the clock,
+    every SEARCH_CHECK_NODES nodes, and also in the threat solver and at
+    depth 1, which the clock never cuts short: a cancelled search returns
+    within a few hundred nodes wherever it is.
+
+    The search never touches the heap: move lists live in a per-ply array in
+    the Search object, sized at compile time by SEARCH_MAX_PLY, so recursion
+    only costs a small frame on the task stack.
+
+    BasicSearch is compiled once per rule set (caro_rules.h); under renju the
+    move generator and the quiescence moves leave out X's forbidden cells.
+*/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <stdlib.h>
+#include "caro_platform.h"
+#include "caro_tt.h"
+#include "caro_threat.h"
+
+#define SEARCH_INF 2000000000
+#define SEARCH_CHECK_NODES 256 // The clock is read once every this many nodes (power of 2)
+#define SEARCH_MAX_PLY 32
+#define SEARCH_ASPIRATION 2500 // Half-width of the first root window, x4 after each fail
+#define QUIESCE_NODE_LIMIT 64  // Default quiescence nodes per horizon leaf
+#define QUIESCE_MAX_PLY 8
+
+// Move ordering scores, highest first
+#define ORDER_HASH        (1 << 30)
+#define ORDER_THREAT_UNIT (1 << 24) // Multiplied by the threat rank (1..10)
+#define ORDER_KILLER_1    (1 << 23)
+#define ORDER_KILLER_2    (ORDER_KILLER_1 - 1)
+#define ORDER_COUNTER     (ORDER_KILLER_1 - 2)
+#define ORDER_HISTORY_MAX (1 << 22) // History is halved when any entry passes this
+
+struct Point {
+    int r, c;
+};
+
+// Fixed-capacity list of squares, filled straight from the candidate bitboard. The search keeps one per ply.
+struct MoveList {
+    uint8_t sq[BOARD_SIZE * BOARD_SIZE];
+    int count;
+};
+
+// Root moves with their scores, O-positive like SearchResult::score
+struct RootScores {
+    uint8_t sq[BOARD_SIZE * BOARD_SIZE];
+    int score[BOARD_SIZE * BOARD_SIZE];
+    int count;
+};
+
+// Call sites brace-initialise every field in order, so -Wextra flags any that a new field would leave out
+struct SearchLimits {
+    int max_depth;
+    uint32_t budget_ms; // 0 = no time limit
+    int vcf_depth;      // Attacker moves in the VCF solver, 0 = off
+    int vct_depth;      // Attacker moves in the VCT solver, 0 = off
+    uint32_t quiesce_nodes; // Quiescence node budget per horizon leaf, 0 = off
+    bool all_root_scores;   // Exact score for every root move in root_scores (hints); slower
+};
+
+enum SearchSource { SOURCE_SEARCH, SOURCE_VCF, SOURCE_VCT, SOURCE_BOOK, SOURCE_MCTS };
+
+// Cheap counters of one think(), kept per thread; the sketch shows them in an overlay and on the serial port
+struct SearchStats {
+    uint32_t nodes;              // Every node, quiescence included
+    uint32_t qnodes;             // Quiescence nodes
+    uint32_t qlimit_hits;        // Leaves whose quiescence ran out of budget
+    uint32_t leaves;             // Nodes at the horizon (depth 0)
+    uint32_t evals;              // Static evaluations (every node looks for a five on the board)
+    uint32_t cutoffs;            // Beta cutoffs below the root
+    uint32_t first_cutoffs;      // ... on the first move tried: the move ordering's hit rate
+    uint32_t expanded;           // Nodes below the root that generated moves
+    uint32_t children;           // Moves searched at those
+    uint32_t tt_probes;
+    uint32_t tt_hits;
+    uint32_t threat_nodes;       // Nodes of the VCF/VCT solver before the search
+    uint32_t iteration_nodes[2]; // Nodes of the last two completed iterations
+    int depth;                   // Last completed iteration
+    int seldepth;                // Deepest ply reached, quiescence included
+    uint32_t elapsed_us;
+
+    // Mean moves searched per expanded node
+    float branching() const { return expanded ? (float)children / expanded : 0.0f; }
+    // Growth of the tree from one iteration to the next
+    float effective_branching() const {
+        return iteration_nodes[0] ? (float)iteration_nodes[1] / iteration_nodes[0] : 0.0f;
+    }
+
+    // Adds the counters of a helper thread; depths and times stay those of the main search
+    void add_counts(const SearchStats& o) {
+        nodes += o.nodes;
+        qnodes += o.qnodes;
+        qlimit_hits += o.qlimit_hits;
+        leaves += o.leaves;
+        evals += o.evals;
+        cutoffs += o.cutoffs;
+        first_cutoffs += o.first_cutoffs;
+        expanded += o.expanded;
+        children += o.children;
+        tt_probes += o.tt_probes;
+        tt_hits += o.tt_hits;
+    }
+};
+
+struct SearchResult {
+    Point move;         // {-1, -1} if no iteration completed
+    int score;
+    int source;         // SearchSource that picked the move
+    SearchStats stats;  // depth and elapsed_us included
+};
+
+// Optional game clock for the AI: the per-move budget comes from the time left,
+// the increment and how far the game has progressed.
+struct GameClock {
+    uint32_t remaining_ms = 0;
+    uint32_t increment_ms = 0;
+
+    void reset(uint32_t base_ms, uint32_t inc_ms) {
+        remaining_ms = base_ms;
+        increment_ms = inc_ms;
+    }
+
+    uint32_t budget_ms(const BitPosition& pos) const {
+        int stone_count = bb_popcount(pos.occupied());
+        int empty = BOARD_SIZE * BOARD_SIZE - stone_count;
+        int moves_left = std::min(std::max(empty / 2, 4), 25);
+
+        uint32_t budget = remaining_ms / moves_left + increment_ms * 3 / 4;
+        if (stone_count < 6) budget /= 2; // Openings are simple, save time for the middlegame
+
+        uint32_t cap = remaining_ms / 2 + increment_ms;
+        if (budget > cap) budget = cap;
+        return std::max(budget, (uint32_t)50);
+    }
+
+    void on_move_done(uint32_t used_ms) {
+        remaining_ms = (remaining_ms > used_ms) ? remaining_ms - used_ms : 0;
+        remaining_ms += increment_ms;
+    }
+};
+
+// One instance per rule set (caro_rules.h); Search is the freestyle one
+template <class Rules>
+struct BasicSearch {
+    BasicPosition<Rules> pos;               // Working copy the search plays on
+    BasicThreatSearch<Rules> threats;
+    TransTable* tt = nullptr;               // Optional, may be shared with other threads
+    CancelCheck cancel;                     // Optional; once cancelled, think() returns within SEARCH_CHECK_NODES nodes
+    const std::atomic<bool>* stop = nullptr; // Optional, set from another thread to end the search
+    int helper_id = 0;                      // 0 = main search; helpers may be stopped at any depth
+    bool age_tt = true;                     // False when the owner of a shared table ages it
+    SearchStats stats = {};              // Of the current or last think()
+    RootScores root_scores = {};         // Of the last think() with all_root_scores; empty if the threat solver answered
+    uint64_t eval_cycles = 0;            // Only counted with -DCARO_PROFILE (caro_platform.h); includes make/undo
+    mutable uint64_t movegen_cycles = 0; // Same
+
+    // Candidates come from the position's incrementally kept near-stone masks; no board scan, no allocation.
+    // Only an empty board falls back to the centre, so a full board yields no moves.
+    void gen_moves(MoveList& list, int range, int player) const {
+        CARO_PROFILE_SCOPE(movegen_cycles);
+        list.count = 0;
+        Bitboard cand = rule_legal<Rules>(pos.candidates(range), pos.stones, player);
+        while (bb_any(cand)) list.sq[list.count++] = (uint8_t)bb_pop_lsb(cand);
+
+        if (pos.stone_count == 0) {
+            list.sq[list.count++] = (uint8_t)bb_square(BOARD_SIZE/2, BOARD_SIZE/2);
+        }
+    }
+
+    // Kept up to date by Position::make_move/unmake_move, one line per direction at a time.
+    // With a net on the position it scores everything but a five on the board.
+    int evaluate_board_gomoku() {
+        CARO_PROFILE_SCOPE(eval_cycles);
+        stats.evals++;
+        if (pos.net && abs(pos.score) < SCORE_WIN / 2) return pos.nnue_score();
+        return pos.score;
+    }
+
+    // Moves on the search's board. Most of the evaluation is done here, by the line updates
+    // of make_move/unmake_move, so the profiler counts them as evaluation.
+    void play(int sq, int player) {
+        CARO_PROFILE_SCOPE(eval_cycles);
+        pos.make_move(sq, player);
+    }
+
+    void undo(int sq, int player) {
+        CARO_PROFILE_SCOPE(eval_cycles);
+        pos.unmake_move(sq, player);
+    }
+
+    int negamax(int depth, int alpha, int beta, int player) {
+        if ((++stats.nodes & (SEARCH_CHECK_NODES - 1)) == 0 && (cancel.cancelled() || (can_abort && should_stop()))) {
+            aborted = true;
+        }
+        if (aborted) return 0;
+        if (ply > stats.seldepth) stats.seldepth = ply;
+
+        int score = evaluate_board_gomoku();
+        if (player == PLAYER_X) score = -score;
+        if (abs(score) > SCORE_WIN / 2) return score;
+        if (depth == 0) {
+            stats.leaves++;
+            if (quiesce_nodes == 0) return score;
+            quiesce_left = quiesce_nodes;
+            return quiesce(alpha, beta, player, 0);
+        }
+
+        uint64_t key = search_key(player);
+        int tt_move = TT_NO_MOVE;
+        TTEntry entry;
+        if (probe_tt(key, entry)) {
+            tt_move = entry.move;
+            if (entry.depth >= depth) {
+                if (entry.bound == TT_EXACT) return entry.score;
+                if (entry.bound == TT_LOWER && entry.score >= beta) return entry.score;
+                if (entry.bound == TT_UPPER && entry.score <= alpha) return entry.score;
+            }
+        }
+
+        MoveList& moves = move_lists[ply];
+        gen_moves(moves, 1, player);
+        if (moves.count == 0) return 0;
+        stats.expanded++;
+
+        int alphaOrig = alpha;
+        int bestSq = TT_NO_MOVE;
+        int bestEval = -SEARCH_INF;
+        order_moves(moves, tt_move, player);
+
+        for (int i = 0; i < moves.count; i++) {
+            int sq = moves.sq[i];
+            stats.children++;
+            play(sq, player);
+            move_stack[ply++] = sq;
+            int eval = pvs_child(depth - 1, alpha, beta, player ^ 1, i == 0);
+            ply--;
+            undo(sq, player);
+            if (aborted) return 0;
+
+            if (eval > bestEval) { bestEval = eval; bestSq = sq; }
+            if (eval > alpha) alpha = eval;
+            if (alpha >= beta) {
+                stats.cutoffs++;
+                if (i == 0) stats.first_cutoffs++;
+                record_cutoff(sq, player, depth);
+                break;
+            }
+        }
+
+        int bound = (bestEval <= alphaOrig) ? TT_UPPER : (bestEval >= beta) ? TT_LOWER : TT_EXACT;
+        if (tt) tt->store(key, depth, bound, bestEval, bestSq);
+        return bestEval;
+    }
+
+    SearchResult think(const BasicPosition<Rules>& root, const SearchLimits& limits) {
+        CaroNoAllocScope no_alloc("Search::think");
+        pos = root;
+        stats = {};
+        eval_cycles = movegen_cycles = 0;
+        quiesce_nodes = limits.quiesce_nodes;
+        all_root_scores = limits.all_root_scores;
+        root_scores.count = 0;
+        aborted = false;
+        ply = 0;
+        memset(killers, 0xFF, sizeof(killers));
+        memset(counter_move, 0xFF, sizeof(counter_move));
+        age_history();
+        int64_t start_us = caro_now_us();
+        deadline_us = limits.budget_ms ? start_us + (int64_t)limits.budget_ms * 1000 : INT64_MAX;
+        if (tt && age_tt) tt->new_search();
+        threats.cancel = &cancel;
+
+        SearchResult result = { {-1, -1}, 0, SOURCE_SEARCH, {} };
+        MoveList& moves = move_lists[0];
+        gen_moves(moves, 1, PLAYER_O);
+
+        if (limits.vcf_depth > 0 && solve_threats(limits, moves, result)) {
+            stats.elapsed_us = (uint32_t)(caro_now_us() - start_us);
+            result.stats = stats;
+            return result;
+        }
+
+        // Lazy SMP: odd helpers start one ply deeper, so the threads are spread over two depths
+        int max_depth = std::min(limits.max_depth, SEARCH_MAX_PLY - 1);
+        for (int depth = 1 + (helper_id & 1); depth <= max_depth; depth++) {
+            can_abort = depth > 1 || helper_id > 0;
+            uint32_t start_nodes = stats.nodes;
+            Point best;
+            int bestVal = search_aspiration(depth, moves, best, result);
+            if (aborted || best.r == -1) break;
+
+            result.move = best;
+            result.score = bestVal;
+            stats.depth = depth;
+            stats.iteration_nodes[0] = stats.iteration_nodes[1];
+            stats.iteration_nodes[1] = stats.nodes - start_nodes;
+
+            // A forced win or loss won't change with more depth
+            if (abs(bestVal) > SCORE_WIN / 2) break;
+            // The next iteration costs several times this one; don't start what can't finish
+            if (limits.budget_ms && (caro_now_us() - start_us) * 2 > (int64_t)limits.budget_ms * 1000) break;
+        }
+
+        stats.elapsed_us = (uint32_t)(caro_now_us() - start_us);
+        result.stats = stats;
+        return result;
+    }
+
+private:
+    int64_t deadline_us = 0;
+    bool can_abort = false;
+    bool aborted = false;
+    uint32_t quiesce_nodes = 0; // From the limits
+    uint32_t quiesce_left = 0;  // Budget left for the current leaf
+    bool all_root_scores = false; // From the limits
+    RootScores iteration_scores;  // Filled by search_root(), kept once the iteration completes
+
+    int ply = 0;
+    int move_stack[SEARCH_MAX_PLY];
+    MoveList move_lists[SEARCH_MAX_PLY]; // [ply]; the root list is [0]
+    int order_scores[BOARD_SIZE * BOARD_SIZE]; // Scratch for order_moves(), which never recurses
+    uint8_t killers[SEARCH_MAX_PLY][2];  // Two latest cutoff moves per ply
+    uint8_t counter_move[2][BB_CELLS];   // [player][previous move] -> move that refuted it
+    int history[2][BB_CELLS] = {};      // [player][square], depth^2 per cutoff
+
+    bool should_stop() const {
+        return caro_now_us() > deadline_us || (stop && stop->load(std::memory_order_relaxed));
+    }
+
+    bool probe_tt(uint64_t key, TTEntry& entry) {
+        if (!tt) return false;
+        stats.tt_probes++;
+        if (!tt->probe(key, entry)) return false;
+        stats.tt_hits++;
+        return true;
+    }
+
+    int find_vcf(int attacker, int depth) {
+        int sq = threats.find_vcf(pos, attacker, depth);
+        stats.threat_nodes += threats.nodes;
+        return sq;
+    }
+
+    int find_vct(int attacker, int depth) {
+        int sq = threats.find_vct(pos, attacker, depth);
+        stats.threat_nodes += threats.nodes;
+        return sq;
+    }
+
+    // True (and result filled in) if O has a forced win. Otherwise, if X threatens a VCF,
+    // narrows the root to the moves within 2 cells after which X has none left.
+    bool solve_threats(const SearchLimits& limits, MoveList& moves, SearchResult& result) {
+        int source = SOURCE_VCF;
+        int sq = find_vcf(PLAYER_O, limits.vcf_depth);
+
+        if (sq < 0 && find_vcf(PLAYER_X, limits.vcf_depth) >= 0) {
+            MoveList& safe = move_lists[1]; // Free until the search starts
+            safe.count = 0;
+            Bitboard cand = pos.candidates(2);
+            while (bb_any(cand) && !cancel.cancelled()) {
+                int m = bb_pop_lsb(cand);
+                play(m, PLAYER_O);
+                if (find_vcf(PLAYER_X, limits.vcf_depth) < 0) safe.sq[safe.count++] = (uint8_t)m;
+                undo(m, PLAYER_O);
+            }
+            if (safe.count > 0) moves = safe;
+            return false;
+        }
+
+        if (sq < 0 && limits.vct_depth > 0) {
+            source = SOURCE_VCT;
+            sq = find_vct(PLAYER_O, limits.vct_depth);
+        }
+        if (sq < 0) return false;
+
+        result.move = {bb_row(sq), bb_col(sq)};
+        result.score = SCORE_WIN;
+        result.source = source;
+        return true;
+    }
+
+    // Forcing moves only, from the side to move's point of view. A five threat must be
+    // blocked; otherwise the side to move may stand pat on the static score.
+    int quiesce(int alpha, int beta, int player, int qply) {
+        if ((++stats.nodes & (SEARCH_CHECK_NODES - 1)) == 0 && (cancel.cancelled() || (can_abort && should_stop()))) {
+            aborted = true;
+        }
+        if (aborted) return 0;
+        stats.qnodes++;
+        if (ply + qply > stats.seldepth) stats.seldepth = ply + qply;
+
+        int stand = evaluate_board_gomoku();
+        if (player == PLAYER_X) stand = -stand;
+        if (abs(stand) > SCORE_WIN / 2) return stand;
+
+        int opp = player ^ 1;
+        Bitboard empty = pos.empty();
+        if (bb_any(rule_five_cells<Rules>(pos.stones[player], pos.stones[opp], empty, player))) return SCORE_WIN; // Five next move
+        Bitboard blocks = rule_five_cells<Rules>(pos.stones[opp], pos.stones[player], empty, opp);
+        int threats = bb_popcount(blocks);
+        if (threats > 1) return -SCORE_WIN;
+
+        if (qply >= QUIESCE_MAX_PLY || quiesce_left == 0) {
+            stats.qlimit_hits++;
+            return stand;
+        }
+        quiesce_left--;
+
+        int bestEval = stand;
+        Bitboard fours, others;
+        if (threats == 1) {
+            bestEval = -SEARCH_INF; // No standing pat against a five
+            fours = rule_legal<Rules>(blocks, pos.stones, player);
+            others = { 0, 0 };
+            if (!bb_any(fours)) return -SCORE_WIN; // Renju: X may not block there
+        } else {
+            if (stand >= beta) return stand;
+            if (stand > alpha) alpha = stand;
+            fours = rule_four_cells<Rules>(pos.stones[player], pos.stones[opp], empty, player);
+            // New threes only on the first ply: deeper they multiply faster than they decide anything
+            others = (qply == 0) ? bb_three_cells(pos.stones[player], empty) : Bitboard{ 0, 0 };
+            Bitboard defences;
+            if (bb_three_defences(pos.stones[opp], empty, defences)) others = others | defences;
+            fours = rule_legal<Rules>(fours, pos.stones, player);
+            others = rule_legal<Rules>(others & empty & ~fours, pos.stones, player);
+        }
+
+        // Fours (or the forced block) first, then threes and blocks of threes
+        for (int pass = 0; pass < 2; pass++) {
+            Bitboard moves = pass ? others : fours;
+            while (bb_any(moves)) {
+                int sq = bb_pop_lsb(moves);
+                play(sq, player);
+                int eval = -quiesce(-beta, -alpha, opp, qply + 1);
+                undo(sq, player);
+                if (aborted) return 0;
+
+                if (eval > bestEval) bestEval = eval;
+                if (eval > alpha) alpha = eval;
+                if (alpha >= beta) return bestEval;
+            }
+        }
+        return bestEval;
+    }
+
+    uint64_t search_key(int player) const {
+        return player == PLAYER_O ? pos.key : pos.key ^ ZOBRIST.side;
+    }
+
+    // Score of the move just made, from the mover's side. The first move gets the full
+    // window; later ones must first beat alpha in a null-window search.
+    int pvs_child(int depth, int alpha, int beta, int opponent, bool first) {
+        if (first) return -negamax(depth, -beta, -alpha, opponent);
+        int eval = -negamax(depth, -alpha - 1, -alpha, opponent);
+        if (eval > alpha && eval < beta && !aborted) eval = -negamax(depth, -beta, -alpha, opponent);
+        return eval;
+    }
+
+    int move_order_score(int sq, int tt_move, int player) const {
+        if (sq == tt_move) return ORDER_HASH;
+
+        // Win > block a win > open four > block an open four > four > open three > block four > block open three
+        static const int attack_rank[] = { 0, 5, 6, 8, 10 };
+        static const int defend_rank[] = { 0, 3, 4, 7, 9 };
+        int rank = std::max(attack_rank[pos.threat_at(sq, player)], defend_rank[pos.threat_at(sq, player ^ 1)]);
+        if (rank) return rank * ORDER_THREAT_UNIT;
+
+        if (ply < SEARCH_MAX_PLY) {
+            if (killers[ply][0] == sq) return ORDER_KILLER_1;
+            if (killers[ply][1] == sq) return ORDER_KILLER_2;
+        }
+        if (ply > 0 && counter_move[player][move_stack[ply - 1]] == sq) return ORDER_COUNTER;
+        return history[player][sq];
+    }
+
+    // Hash move, then threats, killers, counter-move and history. Stable, so ties keep raster order.
+    void order_moves(MoveList& moves, int tt_move, int player) {
+        int n = moves.count;
+        int* scores = order_scores;
+        for (int i = 0; i < n; i++) scores[i] = move_order_score(moves.sq[i], tt_move, player);
+
+        for (int i = 1; i < n; i++) {
+            uint8_t m = moves.sq[i];
+            int s = scores[i];
+            int j = i - 1;
+            for (; j >= 0 && scores[j] < s; j--) {
+                moves.sq[j + 1] = moves.sq[j];
+                scores[j + 1] = scores[j];
+            }
+            moves.sq[j + 1] = m;
+            scores[j + 1] = s;
+        }
+    }
+
+    void record_cutoff(int sq, int player, int depth) {
+        if (ply < SEARCH_MAX_PLY && killers[ply][0] != sq) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = (uint8_t)sq;
+        }
+        if (ply > 0) counter_move[player][move_stack[ply - 1]] = (uint8_t)sq;
+
+        history[player][sq] += depth * depth;
+        if (history[player][sq] > ORDER_HISTORY_MAX) age_history();
+    }
+
+    void age_history() {
+        for (int p = 0; p < 2; p++)
+            for (int sq = 0; sq < BB_CELLS; sq++) history[p][sq] /= 2;
+    }
+
+    // Root search at `depth` inside a window around the last iteration's score, widened
+    // towards whichever side failed until the score lands inside it.
+    int search_aspiration(int depth, MoveList& moves, Point& best, const SearchResult& last) {
+        int delta = SEARCH_ASPIRATION;
+        bool narrow = !all_root_scores && stats.depth > 0 && abs(last.score) < SCORE_WIN / 2;
+        int alpha = narrow ? last.score - delta : -SEARCH_INF;
+        int beta = narrow ? last.score + delta : SEARCH_INF;
+
+        for (;;) {
+            best = {-1, -1};
+            int bestVal = search_root(depth, moves, best, alpha, beta);
+            if (aborted || best.r == -1) return bestVal;
+            if (bestVal > alpha && bestVal < beta) return bestVal;
+
+            delta *= 4;
+            if (delta > SCORE_WIN) {
+                alpha = -SEARCH_INF;
+                beta = SEARCH_INF;
+            } else if (bestVal <= alpha) {
+                alpha = std::max(bestVal - delta, -SEARCH_INF);
+            } else {
+                beta = std::min(bestVal + delta, SEARCH_INF);
+            }
+        }
+    }
+
+    // One pass over the root moves inside (alpha, beta). Returns the best value; best stays
+    // {-1, -1} if the pass was stopped before any move finished. Stops at the first move
+    // that fails high.
+    int search_root(int depth, MoveList& moves, Point& best, int alpha, int beta) {
+        uint64_t rootKey = search_key(PLAYER_O);
+        TTEntry entry;
+        order_moves(moves, probe_tt(rootKey, entry) ? entry.move : TT_NO_MOVE, PLAYER_O);
+
+        int alphaOrig = alpha;
+        int bestVal = -SEARCH_INF;
+        iteration_scores.count = 0;
+        for (int i = 0; i < moves.count; i++) {
+            if (cancel.cancelled() || (can_abort && should_stop())) { aborted = true; break; }
+
+            int sq = moves.sq[i];
+            play(sq, PLAYER_O);
+            move_stack[ply++] = sq;
+            // all_root_scores: no move is bounded by the ones before it
+            int moveVal = all_root_scores ? -negamax(depth - 1, -SEARCH_INF, SEARCH_INF, PLAYER_X)
+                                          : pvs_child(depth - 1, alpha, beta, PLAYER_X, i == 0);
+            ply--;
+            undo(sq, PLAYER_O);
+            if (aborted) break;
+
+            if (all_root_scores) {
+                iteration_scores.sq[iteration_scores.count] = (uint8_t)sq;
+                iteration_scores.score[iteration_scores.count++] = moveVal;
+            }
+
+            if (moveVal > bestVal) {
+                best = {bb_row(sq), bb_col(sq)};
+                bestVal = moveVal;
+            }
+            if (moveVal > alpha) alpha = moveVal;
+            if (alpha >= beta) break;
+            caro_yield();
+        }
+
+        if (!aborted && all_root_scores) root_scores = iteration_scores;
+        if (!aborted && best.r != -1 && tt) {
+            int bound = (bestVal <= alphaOrig) ? TT_UPPER : (bestVal >= beta) ? TT_LOWER : TT_EXACT;
+            tt->store(rootKey, depth, bound, bestVal, bb_square(best.r, best.c));
+        }
+        return bestVal;
+    }
+};
+
+using Search = BasicSearch<FreestyleRules>;
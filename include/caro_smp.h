@@ -0,0 +1,99 @@
+/*
+    Lazy SMP: several Search instances on the same root, sharing one
+    transposition table.
+
+    The main search (workers[0]) runs on the calling thread with the real limits
+    and picks the move. Helper threads run the same iterative deepening with no
+    time limit until the main search returns; they only contribute through the
+    table, which lets the main search cut off or order moves from positions a
+    helper has already searched. Each worker keeps its own killers and history,
+    so the threads drift apart instead of searching identical trees.
+
+    Helper threads are CaroWorkers (caro_platform.h): started by the first
+    think() that needs them, parked between searches and ended by the
+    destructor, so a search costs no task creation.
+*/
+#pragma once
+
+#include "caro_search.h"
+
+#if defined(ESP_PLATFORM)
+#define SMP_MAX_THREADS 2 // One search per core
+#else
+#define SMP_MAX_THREADS 64
+#endif
+
+template <class Rules>
+struct BasicParallelSearch {
+    BasicSearch<Rules> workers[SMP_MAX_THREADS];
+    int threads = 1;      // 1 = plain single-threaded search
+    int helper_core = -1; // Core for the helper threads on the ESP32, -1 = any
+    CancelCheck cancel;   // Handed to every worker by think(); ends it early
+
+    BasicParallelSearch() = default;
+    BasicParallelSearch(const BasicParallelSearch&) = delete; // The helpers point back at it
+    BasicParallelSearch& operator=(const BasicParallelSearch&) = delete;
+
+    ~BasicParallelSearch() {
+        for (int i = 1; i < SMP_MAX_THREADS; i++) caro_worker_stop(helpers[i]);
+    }
+
+    void init(TransTable* tt) {
+        for (int i = 0; i < SMP_MAX_THREADS; i++) {
+            workers[i].tt = tt;
+            workers[i].stop = &stop;
+            workers[i].helper_id = i;
+            workers[i].age_tt = false;
+        }
+        workers[0].stop = nullptr; // Helpers stop when the main search returns
+    }
+
+    SearchResult think(const BasicPosition<Rules>& root, const SearchLimits& limits) {
+        int n = std::max(1, std::min(threads, SMP_MAX_THREADS));
+        if (workers[0].tt) workers[0].tt->new_search();
+        for (int i = 0; i < n; i++) workers[i].cancel = cancel;
+
+        stop.store(false);
+        root_pos = root;
+        helper_limits = limits;
+        helper_limits.budget_ms = 0;
+        helper_limits.vcf_depth = helper_limits.vct_depth = 0;
+
+        int started = 1;
+        for (; started < n; started++) {
+            if (!helpers[started].started) {
+                helper_args[started] = { this, started };
+                if (!caro_worker_start(helpers[started], helper_main, &helper_args[started], helper_core)) break;
+            }
+            caro_worker_run(helpers[started]);
+        }
+
+        SearchResult result = workers[0].think(root, limits);
+
+        stop.store(true);
+        for (int i = 1; i < started; i++) {
+            caro_worker_wait(helpers[i]);
+            result.stats.add_counts(workers[i].stats);
+        }
+        return result;
+    }
+
+private:
+    struct HelperArg {
+        BasicParallelSearch* self;
+        int id;
+    };
+
+    std::atomic<bool> stop{false};
+    CaroWorker helpers[SMP_MAX_THREADS];
+    HelperArg helper_args[SMP_MAX_THREADS];
+    BasicPosition<Rules> root_pos; // Helpers start from this copy, not the caller's position
+    SearchLimits helper_limits = {};
+
+    static void helper_main(void* arg) {
+        HelperArg* a = (HelperArg*)arg;
+        a->self->workers[a->id].think(a->self->root_pos, a->self->helper_limits);
+    }
+};
+
+using ParallelSearch = BasicParallelSearch<FreestyleRules>;
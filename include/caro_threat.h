@@ -0,0 +1,160 @@
+/*
+    Threat-space search: looks only at attacking moves and the replies they force.
+
+    VCF (Victory by Continuous Fours): every attacking move makes a four, so the
+    defender's reply is the single cell that blocks the five. A move that leaves
+    two five-cells (open four, double four) wins outright.
+
+    VCT (Victory by Continuous Threats): attacking moves may also be open threes.
+    After a three the defender may play any cell that breaks all of its
+    straight-four windows, or counter with a four of its own; the attack only
+    counts if it wins against every one of those replies.
+
+    Depths count attacker moves, so depth 10 is a 20-ply forcing line. The
+    branching factor is tiny, and a node limit bounds the worst case; a
+    cancelled search also runs out of nodes at its next check.
+
+    Fives and fours follow the rule set; under Renju, X's forbidden cells are
+    dropped from its attacks and replies.
+*/
+#pragma once
+
+#include "caro_position.h"
+
+#define THREAT_NODE_LIMIT 20000
+#define THREAT_CHECK_NODES 256 // cancel is polled once every this many nodes (power of 2)
+
+template <class Rules>
+struct BasicThreatSearch {
+    uint32_t nodes = 0;
+    uint32_t node_limit = THREAT_NODE_LIMIT;
+    const CancelCheck* cancel = nullptr; // Optional
+
+    // First move of a VCF for `attacker` (who is to move), or -1.
+    int find_vcf(BasicPosition<Rules>& pos, int attacker, int depth) {
+        p = &pos;
+        nodes = 0;
+        int first = -1;
+        return vcf(attacker, depth, &first) ? first : -1;
+    }
+
+    // First move of a VCT for `attacker` (who is to move), or -1.
+    int find_vct(BasicPosition<Rules>& pos, int attacker, int depth) {
+        p = &pos;
+        nodes = 0;
+        int first = -1;
+        return vct(attacker, depth, &first) ? first : -1;
+    }
+
+private:
+    BasicPosition<Rules>* p = nullptr;
+
+    bool out_of_nodes() {
+        if (++nodes > node_limit) return true;
+        if ((nodes & (THREAT_CHECK_NODES - 1)) == 0 && cancel && cancel->cancelled()) {
+            nodes = node_limit; // Every later check fails too
+            return true;
+        }
+        return false;
+    }
+
+    bool vcf(int att, int depth, int* first) {
+        if (out_of_nodes()) return false;
+        int def = att ^ 1;
+        Bitboard empty = p->empty();
+
+        Bitboard wins = rule_five_cells<Rules>(p->stones[att], p->stones[def], empty, att);
+        if (bb_any(wins)) {
+            if (first) *first = bb_pop_lsb(wins);
+            return true;
+        }
+        if (depth == 0) return false;
+
+        // If the defender threatens five, the attacker has to block it, and the block must itself be a four
+        Bitboard def_fives = rule_five_cells<Rules>(p->stones[def], p->stones[att], empty, def);
+        if (bb_popcount(def_fives) > 1) return false;
+        Bitboard cand = rule_four_cells<Rules>(p->stones[att], p->stones[def], empty, att);
+        if (bb_any(def_fives)) cand = cand & def_fives;
+        cand = rule_legal<Rules>(cand, p->stones, att);
+
+        while (bb_any(cand)) {
+            int a = bb_pop_lsb(cand);
+            p->make_move(a, att);
+            bool win = forced_reply(att, depth, false);
+            p->unmake_move(a, att);
+            if (win) {
+                if (first) *first = a;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool vct(int att, int depth, int* first) {
+        if (out_of_nodes()) return false;
+        int def = att ^ 1;
+        Bitboard empty = p->empty();
+
+        Bitboard wins = rule_five_cells<Rules>(p->stones[att], p->stones[def], empty, att);
+        if (bb_any(wins)) {
+            if (first) *first = bb_pop_lsb(wins);
+            return true;
+        }
+        if (depth == 0) return false;
+
+        Bitboard def_fives = rule_five_cells<Rules>(p->stones[def], p->stones[att], empty, def);
+        if (bb_popcount(def_fives) > 1) return false;
+        // A three needs two more attacker moves (straight four, then five), so only try threes with depth to spare
+        Bitboard cand = rule_four_cells<Rules>(p->stones[att], p->stones[def], empty, att);
+        if (depth >= 2) cand = cand | bb_three_cells(p->stones[att], empty);
+        if (bb_any(def_fives)) cand = def_fives; // Forced block; it only helps if it is a threat too
+        cand = rule_legal<Rules>(cand, p->stones, att);
+
+        while (bb_any(cand)) {
+            int a = bb_pop_lsb(cand);
+            p->make_move(a, att);
+            bool win = forced_reply(att, depth, true);
+            p->unmake_move(a, att);
+            if (win) {
+                if (first) *first = a;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The attacker has just moved. True if every defence loses within depth - 1 more attacker moves.
+    bool forced_reply(int att, int depth, bool threes) {
+        int def = att ^ 1;
+        Bitboard empty = p->empty();
+        Bitboard fives = rule_five_cells<Rules>(p->stones[att], p->stones[def], empty, att);
+        int n = bb_popcount(fives);
+
+        if (n >= 2) return true; // Open four or double four
+        if (n == 1) {
+            int d = bb_pop_lsb(fives);
+            if (!bb_any(rule_legal<Rules>(bb_from_square(d), p->stones, def))) return true; // Renju: X may not block there
+            p->make_move(d, def);
+            bool win = threes ? vct(att, depth - 1, nullptr) : vcf(att, depth - 1, nullptr);
+            p->unmake_move(d, def);
+            return win;
+        }
+        if (!threes || depth < 2) return false;
+
+        Bitboard defences;
+        if (!bb_three_defences(p->stones[att], empty, defences)) return false; // Not a threat
+        defences = defences | rule_four_cells<Rules>(p->stones[def], p->stones[att], empty, def);
+        defences = rule_legal<Rules>(defences & empty, p->stones, def);
+
+        while (bb_any(defences)) {
+            int d = bb_pop_lsb(defences);
+            p->make_move(d, def);
+            bool win = vct(att, depth - 1, nullptr);
+            p->unmake_move(d, def);
+            if (!win) return false;
+        }
+        return true;
+    }
+};
+
+using ThreatSearch = BasicThreatSearch<FreestyleRules>;
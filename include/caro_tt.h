@@ -0,0 +1,104 @@
+/*
+    Transposition table keyed by Position::key.
+
+    Buckets hold two entries: the first keeps the deepest result of the current
+    search (depth-preferred, stale ages are always replaced), the second always
+    takes the newest store. Scores are stored as-is: the evaluator has no
+    ply-dependent (mate distance) scores to adjust.
+
+    The table is shared by all parallel search threads without locks. Each slot
+    is two 64-bit words, the packed entry and key ^ entry; a slot torn by two
+    threads writing at once no longer matches its key and reads as a miss.
+*/
+#pragma once
+
+#include <string.h>
+#include "caro_platform.h"
+#include "caro_position.h"
+
+#define TT_DEFAULT_BITS 16 // 65536 slots * 16 bytes = 1 MB of PSRAM
+#define TT_NO_MOVE      0xFF
+
+enum TTBound : uint8_t { TT_NONE, TT_EXACT, TT_LOWER, TT_UPPER }; // TT_NONE marks an empty slot
+
+struct TTEntry {
+    int32_t score;
+    int8_t depth;
+    uint8_t bound;
+    uint8_t move; // Square of the best move, TT_NO_MOVE if none
+    uint8_t age;
+
+    uint64_t pack() const {
+        return (uint32_t)score | (uint64_t)(uint8_t)depth << 32 | (uint64_t)bound << 40 |
+               (uint64_t)move << 48 | (uint64_t)age << 56;
+    }
+
+    static TTEntry unpack(uint64_t d) {
+        return { (int32_t)(uint32_t)d, (int8_t)(d >> 32), (uint8_t)(d >> 40), (uint8_t)(d >> 48), (uint8_t)(d >> 56) };
+    }
+};
+
+struct TTSlot {
+    uint64_t check; // key ^ data
+    uint64_t data;  // TTEntry::pack()
+};
+
+struct TransTable {
+    TTSlot* slots = nullptr;
+    uint32_t mask = 0;
+    uint8_t age = 0;
+
+    bool init(int bits = TT_DEFAULT_BITS) {
+        release();
+        size_t count = (size_t)1 << bits;
+        slots = (TTSlot*)caro_alloc_large(count * sizeof(TTSlot));
+        if (!slots) return false;
+        mask = (uint32_t)(count - 1);
+        clear();
+        return true;
+    }
+
+    void release() {
+        if (slots) caro_free_large(slots);
+        slots = nullptr;
+        mask = 0;
+    }
+
+    void clear() {
+        if (slots) memset(slots, 0, ((size_t)mask + 1) * sizeof(TTSlot));
+        age = 0;
+    }
+
+    // Call once per move, before any search thread starts
+    void new_search() { age++; }
+
+    bool probe(uint64_t key, TTEntry& out) const {
+        if (!slots) return false;
+        const TTSlot* bucket = &slots[key & mask & ~1u];
+        for (int i = 0; i < 2; i++) {
+            uint64_t data = bucket[i].data;
+            if ((bucket[i].check ^ data) != key) continue;
+            out = TTEntry::unpack(data);
+            if (out.bound != TT_NONE) return true;
+        }
+        return false;
+    }
+
+    void store(uint64_t key, int depth, int bound, int score, int move) {
+        if (!slots) return;
+        TTSlot* bucket = &slots[key & mask & ~1u];
+        uint64_t data0 = bucket[0].data;
+        TTEntry e0 = TTEntry::unpack(data0);
+        TTSlot* s = &bucket[1];
+        if ((bucket[0].check ^ data0) == key || e0.age != age || depth >= e0.depth) s = &bucket[0];
+
+        // Keep a known best move when re-storing the same position without one
+        uint64_t old = s->data;
+        if (move == TT_NO_MOVE && (s->check ^ old) == key) move = TTEntry::unpack(old).move;
+
+        TTEntry e = { score, (int8_t)depth, (uint8_t)bound, (uint8_t)move, age };
+        uint64_t data = e.pack();
+        s->data = data;
+        s->check = key ^ data;
+    }
+};
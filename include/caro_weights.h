@@ -0,0 +1,20 @@
+/*
+    Evaluation weights, indexed by SegmentShape (caro_position.h) from
+    SHAPE_NONE to SHAPE_OPEN_4. A five is not tuned: it always scores SCORE_WIN.
+
+    Hand-picked values; tools/tune_eval.cpp rewrites this file.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#define EVAL_WEIGHT_COUNT 6
+
+static constexpr int32_t EVAL_WEIGHTS[EVAL_WEIGHT_COUNT] = {
+    0,     // none
+    500,   // open two
+    1000,  // blocked three
+    5000,  // open three
+    10000, // blocked four
+    50000, // open four
+};
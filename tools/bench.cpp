@@ -0,0 +1,34 @@
+/*
+    Runs the fixed benchmark of include/caro_bench.h and prints its CSV, to
+    compare a change against a saved run (diff, or any CSV tool).
+
+    Build and run from the repository root; the profiled build fills in
+    eval_us and movegen_us, the plain one gives the real nodes per second:
+        g++ -std=gnu++17 -O2 -I include tools/bench.cpp -o bench
+        g++ -std=gnu++17 -O2 -DCARO_PROFILE -I include tools/bench.cpp -o bench_profile
+        ./bench [depth_delta] [tt_bits] [nnue_file] > run.csv
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "caro_bench.h"
+
+static Search search;
+static TransTable tt;
+static NnueNet net;
+
+int main(int argc, char** argv) {
+    int depth_delta = (argc > 1) ? atoi(argv[1]) : 0;
+    int tt_bits = (argc > 2) ? atoi(argv[2]) : 20;
+    if (tt.init(tt_bits)) search.tt = &tt;
+
+    if (argc > 3) {
+        size_t size = 0;
+        const void* blob = caro_map_readonly(argv[3], &size);
+        if (!net.load(blob, size)) {
+            fprintf(stderr, "No valid net in %s\n", argv[3]);
+            return 1;
+        }
+    }
+    caro_bench_run(search, [](const char* line) { puts(line); }, depth_delta, (argc > 3) ? &net : nullptr);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+    Builds the opening book (see include/caro_book.h) by searching every
+    position the AI ('O') can face in the first moves of a game: O starting on
+    the empty board, or X opening anywhere, and then every X reply next to the
+    stones while O follows its own book moves.
+
+    Positions proven by tools/solve_pn.cpp can be merged in: their moves
+    replace the search, and every solved entry is copied to the output.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O2 -pthread -I include tools/make_book.cpp -o make_book
+        ./make_book [max_stones] [depth] [out_file] [solved_file]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include "caro_book.h"
+#include "caro_search.h"
+
+static Search search;
+static TransTable tt;
+static std::map<uint64_t, uint8_t> book; // Canonical key -> canonical move
+static std::map<uint64_t, uint8_t> solved; // Same, read from a solve_pn file
+static int max_stones = 5;
+static int depth = 8;
+
+// O to move in pos: search it once per symmetry class, play the move, then try every X reply
+static void expand(Position& pos) {
+    if (pos.stone_count > max_stones) return;
+    int sym;
+    uint64_t key = book_key(pos, PLAYER_O, &sym);
+    if (book.count(key)) return;
+
+    int sq;
+    auto proven = solved.find(key);
+    if (proven != solved.end() && proven->second < BB_CELLS) {
+        sq = book_inverse(proven->second, sym);
+    } else {
+        // The Hard limits without the clock, quiescence included, so the book plays like the search it replaces
+        SearchResult r = search.think(pos, { depth, 0, 10, 4, QUIESCE_NODE_LIMIT, false });
+        if (r.move.r == -1) return;
+        sq = bb_square(r.move.r, r.move.c);
+    }
+    book[key] = (uint8_t)book_transform(sq, sym);
+    if (book.size() % 100 == 0) fprintf(stderr, "%zu positions\n", book.size());
+
+    pos.make_move(sq, PLAYER_O);
+    if (abs(pos.score) < SCORE_WIN / 2 && pos.stone_count < max_stones) {
+        Bitboard replies = pos.candidates(1);
+        while (bb_any(replies)) {
+            int x = bb_pop_lsb(replies);
+            pos.make_move(x, PLAYER_X);
+            if (abs(pos.score) < SCORE_WIN / 2) expand(pos);
+            pos.unmake_move(x, PLAYER_X);
+        }
+    }
+    pos.unmake_move(sq, PLAYER_O);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) max_stones = atoi(argv[1]);
+    if (argc > 2) depth = atoi(argv[2]);
+    const char* out = (argc > 3) ? argv[3] : "book/caro_book.bin";
+    uint32_t book_stones = max_stones;
+
+    if (argc > 4) {
+        size_t size = 0;
+        const void* data = caro_map_readonly(argv[4], &size);
+        OpeningBook proven;
+        if (!proven.open(data, size)) {
+            printf("Cannot read %s\n", argv[4]);
+            return 1;
+        }
+        for (uint32_t i = 0; i < proven.count; i++) solved[proven.keys[i]] = proven.moves[i];
+        if (proven.max_stones > book_stones) book_stones = proven.max_stones;
+        printf("%u solved positions from %s\n", proven.count, argv[4]);
+    }
+
+    if (!tt.init(20)) {
+        printf("TT alloc failed\n");
+        return 1;
+    }
+    search.tt = &tt;
+
+    Position pos;
+    pos.clear();
+    expand(pos); // O starts
+    for (int sq = 0; sq < BB_CELLS; sq++) {
+        if (bb_col(sq) >= BOARD_SIZE) continue;
+        pos.make_move(sq, PLAYER_X); // X starts anywhere
+        expand(pos);
+        pos.unmake_move(sq, PLAYER_X);
+    }
+
+    for (auto& e : solved) book[e.first] = e.second;
+
+    FILE* f = fopen(out, "wb");
+    if (!f) {
+        printf("Cannot write %s\n", out);
+        return 1;
+    }
+    BookHeader h = { BOOK_MAGIC, (uint32_t)book.size(), book_stones, 0 };
+    fwrite(&h, sizeof(h), 1, f);
+    for (auto& e : book) fwrite(&e.first, sizeof(uint64_t), 1, f);
+    for (auto& e : book) fwrite(&e.second, 1, 1, f);
+    fclose(f);
+
+    printf("%u positions (up to %d stones, depth %d) -> %s\n", h.count, max_stones, depth, out);
+    tt.release();
+    return 0;
+}
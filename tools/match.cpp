@@ -0,0 +1,272 @@
+/*
+    Match runner: plays two engine configurations against each other on all
+    cores and stops as soon as a sequential probability ratio test (SPRT)
+    decides whether A is stronger than B.
+
+    Every opening is a random 4-stone position in the middle 6x6 and is played
+    twice, each engine taking each colour once. After every pair the runner
+    updates the score and the log-likelihood ratio of elo1 against elo0
+    (normal approximation to the trinomial win/draw/loss model, as in
+    cutechess-cli and fishtest) and stops at the bounds given by alpha and
+    beta, or after max_games.
+
+    An engine is a preset optionally followed by comma-separated settings:
+        hard            the Hard level: depth 10, 1500 ms, VCF 10, VCT 4, quiescence
+        medium          the Medium level: depth 2, 300 ms, quiescence
+        mcts            the MCTS level: 1500 ms of playouts
+        depth=N ms=N vcf=N vct=N qnodes=N   override a SearchLimits field (ms=0: no time limit)
+        iters=N         cap MCTS playouts per move; mcts needs ms > 0 or iters > 0
+        nnue=FILE       evaluate with the net in FILE (tools/train_nnue.cpp)
+    e.g. "hard,ms=100" against "hard,ms=100,nnue=book/caro_nnue.bin". Each
+    engine searches single-threaded with its own transposition table; time
+    limits assume one game per core.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O2 -pthread -I include tools/match.cpp -o match
+        ./match <engine_a> <engine_b> [max_games] [threads] [rules] [elo0] [elo1] [alpha] [beta] [seed]
+    rules: freestyle, exact or caro. Defaults: 2000 games, all cores,
+    freestyle, H0 elo 0, H1 elo 10, alpha = beta = 0.05.
+
+    Not renju: the engines search a colour-swapped view in which they are
+    always O, so under renju black would search as the unrestricted side and
+    play forbidden moves. That needs a search for either colour first.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "caro_mcts.h"
+#include "selfplay.h"
+
+#define MATCH_TT_BITS 18
+
+struct EngineConfig {
+    std::string name;
+    SearchLimits limits;
+    bool mcts;
+    uint32_t iterations; // MCTS playouts per move, 0 = until the clock runs out
+    NnueNet net;
+    bool use_net;
+};
+
+static bool parse_engine(const char* spec, EngineConfig& e) {
+    e.name = spec;
+    e.limits = { 10, 1500, 10, 4, QUIESCE_NODE_LIMIT, false };
+    e.mcts = false;
+    e.iterations = 0;
+    e.use_net = false;
+
+    std::string s = spec;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) end = s.size();
+        std::string item = s.substr(start, end - start);
+        start = end + 1;
+
+        size_t eq = item.find('=');
+        std::string key = item.substr(0, eq), value = (eq == std::string::npos) ? "" : item.substr(eq + 1);
+        int n = atoi(value.c_str());
+        if (key == "hard") {
+            e.limits = { 10, 1500, 10, 4, QUIESCE_NODE_LIMIT, false };
+        } else if (key == "medium") {
+            e.limits = { 2, 300, 0, 0, QUIESCE_NODE_LIMIT, false };
+        } else if (key == "mcts") {
+            e.limits = { 0, 1500, 0, 0, 0, false };
+            e.mcts = true;
+        } else if (key == "depth") {
+            e.limits.max_depth = n;
+        } else if (key == "ms") {
+            e.limits.budget_ms = (uint32_t)n;
+        } else if (key == "vcf") {
+            e.limits.vcf_depth = n;
+        } else if (key == "vct") {
+            e.limits.vct_depth = n;
+        } else if (key == "qnodes") {
+            e.limits.quiesce_nodes = (uint32_t)n;
+        } else if (key == "iters") {
+            e.iterations = (uint32_t)n;
+        } else if (key == "nnue") {
+            size_t size = 0;
+            const void* blob = caro_map_readonly(value.c_str(), &size);
+            if (!e.net.load(blob, size)) {
+                printf("No valid net in %s\n", value.c_str());
+                return false;
+            }
+            e.use_net = true;
+        } else {
+            printf("Unknown engine setting '%s' in %s\n", item.c_str(), spec);
+            return false;
+        }
+    }
+    if (!e.mcts && e.limits.max_depth <= 0) {
+        printf("%s: the search needs depth > 0\n", spec);
+        return false;
+    }
+    if (e.mcts && e.limits.budget_ms == 0 && e.iterations == 0) {
+        printf("%s: MCTS only stops on the clock or an iteration cap, give ms > 0 or iters > 0\n", spec);
+        return false;
+    }
+    return true;
+}
+
+// One engine as a worker thread runs it: search or MCTS, with its own table
+template <class Rules>
+struct Player {
+    const EngineConfig* config;
+    std::unique_ptr<BasicSearch<Rules>> search;
+    std::unique_ptr<BasicMcts<Rules>> mcts;
+    TransTable tt;
+
+    bool init(const EngineConfig* c) {
+        config = c;
+        if (c->mcts) {
+            mcts.reset(new BasicMcts<Rules>());
+            return mcts->init();
+        }
+        search.reset(new BasicSearch<Rules>());
+        if (tt.init(MATCH_TT_BITS)) search->tt = &tt;
+        return true;
+    }
+
+    void new_game() {
+        if (mcts) mcts->init(); // No subtree from the last game
+        else tt.clear();
+    }
+
+    int move(const BasicPosition<Rules>& game, int side) {
+        const NnueNet* net = config->use_net ? &config->net : nullptr;
+        if (!mcts) return result_square(engine_think(*search, game, side, config->limits, nullptr, net));
+        BasicPosition<Rules> view;
+        side_view(game, side, view, nullptr, net);
+        return result_square(mcts->think(view, config->limits, config->iterations));
+    }
+};
+
+// Winner (PLAYER_X / PLAYER_O) or -1 for a draw
+template <class Rules>
+static int play_game(Player<Rules>* players[2], uint64_t seed) {
+    uint64_t rng = seed;
+    BasicPosition<Rules> game;
+    game.clear();
+    random_opening(game, rng, 6);
+    players[0]->new_game();
+    players[1]->new_game();
+    return play_out(game, [&](const BasicPosition<Rules>& g, int turn) { return players[turn]->move(g, turn); });
+}
+
+static double elo_of(double score) {
+    score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static double score_of(double elo) { return 1.0 / (1.0 + pow(10.0, -elo / 400.0)); }
+
+// Mean score of A and its per-game variance
+static void score_variance(const GameTally& m, double& score, double& var) {
+    double n = m.games();
+    score = (m.wins + 0.5 * m.draws) / n;
+    var = (m.wins * (1 - score) * (1 - score) + m.draws * (0.5 - score) * (0.5 - score) + m.losses * score * score) / n;
+}
+
+static double llr(const GameTally& m, double elo0, double elo1) {
+    if (m.games() == 0) return 0;
+    double score, var;
+    score_variance(m, score, var);
+    if (var <= 0) return 0;
+    double s0 = score_of(elo0), s1 = score_of(elo1);
+    return m.games() * (s1 - s0) * (2 * score - s0 - s1) / (2 * var);
+}
+
+static void report(const GameTally& m, double elo0, double elo1, double lower, double upper) {
+    double score, var;
+    score_variance(m, score, var);
+    double margin = 1.96 * sqrt(var / m.games());
+    double elo = elo_of(score), lo = elo_of(score - margin), hi = elo_of(score + margin);
+    printf("%5d games: +%d -%d =%d  score %.1f%%  Elo %+.1f [%+.1f, %+.1f]  LLR %.2f [%.2f, %.2f] (elo0 %g, elo1 %g)\n",
+           m.games(), m.wins, m.losses, m.draws, 100 * score, elo, lo, hi, llr(m, elo0, elo1), lower, upper, elo0, elo1);
+    fflush(stdout);
+}
+
+template <class Rules>
+static int run(const EngineConfig* config, int max_games, int threads, double elo0, double elo1,
+               double alpha, double beta, uint64_t seed) {
+    const double lower = log(beta / (1 - alpha)), upper = log((1 - beta) / alpha);
+    std::atomic<int> next_pair{0};
+    std::atomic<bool> stop{false};
+    std::mutex lock;
+    GameTally stats = { 0, 0, 0 }; // For engine A
+    int verdict = 0; // 1 H1 accepted, -1 H0 accepted
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&] {
+            Player<Rules> a, b;
+            if (!a.init(&config[0]) || !b.init(&config[1])) {
+                printf("Alloc failed\n");
+                stop = true;
+                return;
+            }
+            for (int p; !stop && (p = next_pair.fetch_add(1)) < max_games / 2;) {
+                uint64_t opening = seed ^ (0x9E3779B97F4A7C15ULL * (uint64_t)(p + 1));
+                GameTally pair = { 0, 0, 0 };
+                for (int a_side = 0; a_side < 2; a_side++) {
+                    Player<Rules>* players[2] = { a_side == PLAYER_X ? &a : &b, a_side == PLAYER_X ? &b : &a };
+                    pair.add(play_game<Rules>(players, opening), a_side);
+                }
+
+                std::lock_guard<std::mutex> hold(lock);
+                stats.add(pair);
+                double l = llr(stats, elo0, elo1);
+                if (!verdict && (l >= upper || l <= lower)) {
+                    verdict = (l >= upper) ? 1 : -1;
+                    stop = true;
+                }
+                if (stats.games() % 20 == 0) report(stats, elo0, elo1, lower, upper);
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    if (stats.games() == 0) return 1;
+
+    report(stats, elo0, elo1, lower, upper);
+    if (verdict > 0) printf("SPRT: H1 accepted, %s is stronger than %s\n", config[0].name.c_str(), config[1].name.c_str());
+    else if (verdict < 0) printf("SPRT: H0 accepted, %s is not %g Elo stronger than %s\n", config[0].name.c_str(), elo1, config[1].name.c_str());
+    else printf("SPRT: no decision after %d games\n", stats.games());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <engine_a> <engine_b> [max_games] [threads] [rules] [elo0] [elo1] [alpha] [beta] [seed]\n", argv[0]);
+        return 1;
+    }
+    static EngineConfig config[2];
+    if (!parse_engine(argv[1], config[0]) || !parse_engine(argv[2], config[1])) return 1;
+    int max_games = (argc > 3) ? atoi(argv[3]) : 2000;
+    int threads = (argc > 4) ? atoi(argv[4]) : (int)std::thread::hardware_concurrency();
+    const char* rules = (argc > 5) ? argv[5] : "freestyle";
+    double elo0 = (argc > 6) ? atof(argv[6]) : 0.0;
+    double elo1 = (argc > 7) ? atof(argv[7]) : 10.0;
+    double alpha = (argc > 8) ? atof(argv[8]) : 0.05;
+    double beta = (argc > 9) ? atof(argv[9]) : 0.05;
+    uint64_t seed = (argc > 10) ? strtoull(argv[10], nullptr, 10) : 1;
+    if (threads < 1) threads = 1;
+
+    printf("%s vs %s, %s rules, up to %d games on %d threads\n", config[0].name.c_str(), config[1].name.c_str(), rules, max_games, threads);
+    if (!strcmp(rules, "freestyle")) return run<FreestyleRules>(config, max_games, threads, elo0, elo1, alpha, beta, seed);
+    if (!strcmp(rules, "exact")) return run<ExactFiveRules>(config, max_games, threads, elo0, elo1, alpha, beta, seed);
+    if (!strcmp(rules, "caro")) return run<CaroRules>(config, max_games, threads, elo0, elo1, alpha, beta, seed);
+    if (!strcmp(rules, "renju")) {
+        printf("Renju is not supported: the engines always search as O, the side without forbidden moves\n");
+        return 1;
+    }
+    printf("Unknown rules %s\n", rules);
+    return 1;
+}
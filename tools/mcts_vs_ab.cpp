@@ -0,0 +1,49 @@
+/*
+    Plays the MCTS engine against the alpha-beta search (Hard settings) with
+    the same time per move, from random 4-stone openings, each engine taking
+    each colour once per opening.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O2 -pthread -I include tools/mcts_vs_ab.cpp -o mcts_vs_ab
+        ./mcts_vs_ab [ms_per_move] [openings] [mcts_threads]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "caro_mcts.h"
+#include "selfplay.h"
+
+static Mcts mcts;
+static Search ab;
+static TransTable tt;
+
+int main(int argc, char** argv) {
+    uint32_t ms = (argc > 1) ? (uint32_t)atoi(argv[1]) : 200;
+    int openings = (argc > 2) ? atoi(argv[2]) : 10;
+    mcts.threads = (argc > 3) ? atoi(argv[3]) : 1;
+
+    if (!tt.init(20) || !mcts.init()) {
+        printf("Alloc failed\n");
+        return 1;
+    }
+    ab.tt = &tt;
+
+    SearchLimits limits = { 10, ms, 10, 4, QUIESCE_NODE_LIMIT, false };
+    GameTally score = { 0, 0, 0 }; // For MCTS
+    for (int g = 0; g < openings * 2; g++) {
+        uint64_t rng = 0xD1B54A32D192ED03ULL * (uint64_t)(g / 2 + 1);
+        Position game;
+        game.clear();
+        random_opening(game, rng, 4);
+        mcts.init(); // No subtree from the last game
+        tt.clear();
+
+        int mcts_side = g % 2;
+        int winner = play_out(game, [&](const Position& p, int turn) {
+            return result_square((turn == mcts_side) ? engine_think(mcts, p, turn, limits) : engine_think(ab, p, turn, limits));
+        });
+        score.add(winner, mcts_side);
+        printf("game %d: %s\n", g + 1, winner < 0 ? "draw" : (winner == mcts_side) ? "MCTS" : "alpha-beta");
+    }
+    printf("%u ms/move: MCTS %d, alpha-beta %d, draws %d\n", ms, score.wins, score.losses, score.draws);
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+    Checks the renju forbidden-move test (rule_forbidden in caro_rules.h) on
+    hand-made positions: each case is a board, the cell X would play ('*')
+    and whether that move is forbidden. Prints the failing cases and exits
+    with 1 if there are any.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O2 -I include tools/rules_check.cpp -o rules_check
+        ./rules_check
+*/
+#include <stdio.h>
+#include "caro_rules.h"
+
+struct RuleCase {
+    const char* name;
+    bool forbidden;
+    const char* rows[BOARD_SIZE]; // 'X', 'O', '.' or '*' for the move
+};
+
+static const RuleCase CASES[] = {
+    { "open four", false, {
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        "..XX*X....",
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "double four on one line X_XXX_X", true, {
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        ".X.X*X.X..",
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "double four on one line XX_XX_XX", true, {
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        "XX.X*.XX..",
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "double four on two lines", true, {
+        "..........",
+        "..........",
+        "....X.....",
+        "....X.....",
+        "....X.....",
+        ".XXX*.....",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "double three", true, {
+        "..........",
+        "..........",
+        "..........",
+        "....X.....",
+        "....X.....",
+        "..XX*.....",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "four-three", false, {
+        "..........",
+        "..........",
+        "....X.....",
+        "....X.....",
+        "....X.....",
+        "..XX*.....",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "overline", true, {
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        ".XXX*XX...",
+        "..........",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+    { "five beats a double four", false, {
+        "..........",
+        "..........",
+        "....X.....",
+        "....X.....",
+        "....X.....",
+        "XXXX*.....",
+        "..........",
+        "..........",
+        "..........",
+        ".........." } },
+};
+
+int main() {
+    int failed = 0;
+    for (const RuleCase& c : CASES) {
+        Bitboard x = { 0, 0 }, o = { 0, 0 };
+        int sq = -1;
+        for (int r = 0; r < BOARD_SIZE; r++) {
+            for (int col = 0; col < BOARD_SIZE; col++) {
+                char ch = c.rows[r][col];
+                if (ch == 'X') x = x | bb_from_square(bb_square(r, col));
+                if (ch == 'O') o = o | bb_from_square(bb_square(r, col));
+                if (ch == '*') sq = bb_square(r, col);
+            }
+        }
+        bool got = rule_forbidden<RenjuRules>(x, o, sq);
+        if (got != c.forbidden) {
+            printf("FAIL %s: forbidden %d, expected %d\n", c.name, got, c.forbidden);
+            failed++;
+        }
+    }
+    printf("%d/%d cases passed\n", (int)(sizeof(CASES) / sizeof(CASES[0])) - failed, (int)(sizeof(CASES) / sizeof(CASES[0])));
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/*
+    Self-play harness shared by the Linux tools that play engines against
+    each other (match, mcts_vs_ab, tune_eval, train_nnue): the random
+    generator, random openings, the colour-swapped view the engines search
+    and the game loop.
+
+    The engines only ever search as O, so the side to move is handed the O
+    stones of a copy of the game. The loop checks fives with the rule set's
+    own test, so it plays any rules but renju, where black would search as
+    the unrestricted side.
+*/
+#pragma once
+
+#include "caro_search.h"
+
+#define SELFPLAY_OPENING_STONES 4
+
+static uint64_t next_random(uint64_t& s) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return s;
+}
+
+// SELFPLAY_OPENING_STONES stones, X first, on random empty cells of the middle span x span square
+template <class Rules>
+static void random_opening(BasicPosition<Rules>& game, uint64_t& rng, int span) {
+    int first = (BOARD_SIZE - span) / 2;
+    for (int i = 0; i < SELFPLAY_OPENING_STONES; i++) {
+        int sq;
+        do sq = bb_square(first + (int)(next_random(rng) % span), first + (int)(next_random(rng) % span)); while (!bb_test(game.empty(), sq));
+        game.make_move(sq, i % 2);
+    }
+}
+
+// game as `side` sees it: its stones are O's, evaluated with w or net when given
+template <class Rules>
+static void side_view(const BasicPosition<Rules>& game, int side, BasicPosition<Rules>& view,
+                      const EvalWeights* w = nullptr, const NnueNet* net = nullptr) {
+    view.clear();
+    if (w) view.set_weights(w);
+    if (net) view.set_net(net);
+    for (int p = 0; p < 2; p++) {
+        Bitboard s = game.stones[p];
+        while (bb_any(s)) view.make_move(bb_pop_lsb(s), (p == side) ? PLAYER_O : PLAYER_X);
+    }
+}
+
+// Engine is a BasicSearch or a BasicMcts; the result's score is for `side`
+template <class Engine, class Rules>
+static SearchResult engine_think(Engine& engine, const BasicPosition<Rules>& game, int side, const SearchLimits& limits,
+                                 const EvalWeights* w = nullptr, const NnueNet* net = nullptr) {
+    BasicPosition<Rules> view;
+    side_view(game, side, view, w, net);
+    return engine.think(view, limits);
+}
+
+static int result_square(const SearchResult& r) { return (r.move.r < 0) ? -1 : bb_square(r.move.r, r.move.c); }
+
+// Plays game out with X to move, move(game, turn) giving each square (-1 to stop).
+// Returns the winner (PLAYER_X / PLAYER_O) or -1 for a draw.
+template <class Rules, class MoveFn>
+static int play_out(BasicPosition<Rules>& game, MoveFn move) {
+    for (int turn = PLAYER_X; bb_any(game.empty()); turn ^= 1) {
+        int sq = move(game, turn);
+        if (sq < 0) break;
+        game.make_move(sq, turn);
+        if (rule_has_five<Rules>(game.stones[turn], game.stones[turn ^ 1], turn)) return turn;
+    }
+    return -1;
+}
+
+// Results of one engine, fed with play_out winners and the side it played
+struct GameTally {
+    int wins, losses, draws;
+
+    int games() const { return wins + losses + draws; }
+    double points() const { return wins + draws / 2.0; }
+
+    void add(int winner, int side) {
+        if (winner < 0) draws++;
+        else if (winner == side) wins++;
+        else losses++;
+    }
+    void add(const GameTally& t) {
+        wins += t.wins;
+        losses += t.losses;
+        draws += t.draws;
+    }
+};
@@ -0,0 +1,82 @@
+/*
+    Lazy SMP scaling on a Linux host: searches the same positions to a fixed
+    depth with 1, 2, 4 ... threads and prints the time and the speedup over
+    one thread. Threads beyond the host's cores only time-share, so the
+    speedup column means nothing past hardware_concurrency.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O2 -pthread -I include tools/smp_speedup.cpp -o smp_speedup
+        ./smp_speedup [depth] [max_threads] [tt_bits]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include "caro_smp.h"
+
+#define BENCH_POSITIONS 8
+
+static ParallelSearch smp;
+static TransTable tt;
+
+// Reproducible middlegame positions: random near-stone moves, X first, redrawing any that
+// would end the game, so the colours alternate. plies odd leaves O to move. False if the
+// seed runs out of tries short of plies stones.
+static bool make_position(Position& p, int seed, int plies) {
+    srand(seed);
+    p.clear();
+    p.make_move(bb_square(4 + rand() % 2, 4 + rand() % 2), PLAYER_X);
+    for (int tries = 0; p.stone_count < plies && tries < plies * 8; tries++) {
+        Bitboard cand = p.candidates(1);
+        int n = rand() % bb_popcount(cand);
+        int sq = bb_pop_lsb(cand);
+        while (n--) sq = bb_pop_lsb(cand);
+
+        int player = (p.stone_count % 2) ? PLAYER_O : PLAYER_X;
+        p.make_move(sq, player);
+        if (abs(p.score) > SCORE_WIN / 2 || bb_any(bb_five_cells(p.stones[player], p.empty()))) {
+            p.unmake_move(sq, player);
+        }
+    }
+    return p.stone_count == plies;
+}
+
+int main(int argc, char** argv) {
+    int depth = (argc > 1) ? atoi(argv[1]) : 6;
+    int max_threads = (argc > 2) ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    int tt_bits = (argc > 3) ? atoi(argv[3]) : 20;
+    max_threads = std::max(1, std::min(max_threads, SMP_MAX_THREADS));
+
+    if (!tt.init(tt_bits)) {
+        printf("TT alloc failed\n");
+        return 1;
+    }
+    smp.init(&tt);
+
+    Position positions[BENCH_POSITIONS];
+    for (int i = 0, seed = 1; i < BENCH_POSITIONS; seed++) {
+        if (make_position(positions[i], seed, 9 + 2 * i)) i++;
+    }
+
+    int cores = (int)std::thread::hardware_concurrency();
+    printf("depth %d, %d positions, %d hardware threads\n", depth, BENCH_POSITIONS, cores);
+    if (max_threads > cores) printf("More threads than hardware threads: the speedup past %d is not a measurement\n", cores);
+    printf("threads      time_ms    nodes        speedup\n");
+
+    double base_ms = 0;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        smp.threads = threads;
+        uint64_t nodes = 0;
+        int64_t start = caro_now_us();
+        for (int i = 0; i < BENCH_POSITIONS; i++) {
+            tt.clear();
+            SearchResult r = smp.think(positions[i], { depth, 0, 0, 0, 0, false });
+            nodes += r.stats.nodes;
+        }
+        double ms = (caro_now_us() - start) / 1000.0;
+        if (threads == 1) base_ms = ms;
+        printf("%-12d %-10.0f %-12llu %.2fx\n", threads, ms, (unsigned long long)nodes, base_ms / ms);
+    }
+
+    tt.release();
+    return 0;
+}
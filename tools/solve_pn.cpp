@@ -0,0 +1,317 @@
+/*
+    Solves opening positions with depth-first proof-number search (df-pn) on
+    several threads and writes the proven ones in the opening book format
+    (include/caro_book.h), ready to be merged by make_book.
+
+    Every canonical position up to max_stones is tried twice: once to prove
+    a win for the side to move, once to prove a win for the opponent (a loss).
+    Wins are stored with the winning move, losses with BOOK_LOST; positions
+    not solved within the node limit are left out.
+
+    The rules are the game's: five or more in a row wins (bb_five_cells, the
+    same runs as check_win_and_fill_positions), a full board is a draw, and a
+    draw counts as a failed proof. Moves searched:
+      - a five on the board ends the game, a single five threat must be blocked
+      - the attacker plays next to the stones (restricting the attacker keeps
+        proofs sound, it only makes some of them harder to find)
+      - the defender answers an open three with the cells that break it or a
+        four of its own, as in caro_threat.h; otherwise with every empty cell
+
+    Threads take root positions from a shared counter and share one lock-free
+    proof table, so transpositions found by one thread save work for the others.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O3 -pthread -I include tools/solve_pn.cpp -o solve_pn
+        ./solve_pn [max_stones] [node_limit] [threads] [out_file]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+#include "caro_book.h"
+#include "caro_tt.h"
+
+#define PN_INF        0xFFFFFF // Proof / disproof numbers are 24 bits
+#define PN_TABLE_BITS 22       // 4M slots * 16 bytes = 64 MB
+#define PN_ATTACKER_O 0x9E3779B97F4A7C15ull // Xored into the key when O is the attacker
+
+// (phi, delta) from the point of view of the side to move: phi = 0 means it wins, delta = 0 that it does not
+struct PnEntry {
+    uint32_t phi, delta, work;
+
+    uint64_t pack() const { return (uint64_t)phi | (uint64_t)delta << 24 | (uint64_t)work << 48; }
+    static PnEntry unpack(uint64_t d) { return { (uint32_t)(d & PN_INF), (uint32_t)(d >> 24 & PN_INF), (uint32_t)(d >> 48) }; }
+};
+
+// Same layout and xor check as TransTable: two slots per bucket, the first keeps the most work
+struct PnTable {
+    TTSlot* slots = nullptr;
+    uint64_t mask = 0;
+
+    bool init(int bits) {
+        size_t count = (size_t)1 << bits;
+        slots = (TTSlot*)caro_alloc_large(count * sizeof(TTSlot));
+        if (!slots) return false;
+        memset(slots, 0, count * sizeof(TTSlot));
+        mask = count - 1;
+        return true;
+    }
+
+    bool probe(uint64_t key, PnEntry& out) const {
+        const TTSlot* bucket = &slots[key & mask & ~1ull];
+        for (int i = 0; i < 2; i++) {
+            uint64_t data = bucket[i].data;
+            if (data == 0 || (bucket[i].check ^ data) != key) continue;
+            out = PnEntry::unpack(data);
+            return true;
+        }
+        return false;
+    }
+
+    void store(uint64_t key, uint32_t phi, uint32_t delta, uint64_t work) {
+        TTSlot* bucket = &slots[key & mask & ~1ull];
+        PnEntry e0 = PnEntry::unpack(bucket[0].data);
+        TTSlot* s = &bucket[1];
+        if ((bucket[0].check ^ bucket[0].data) == key || work >= e0.work) s = &bucket[0];
+        uint64_t data = PnEntry{ phi, delta, (uint32_t)(work > 0xFFFF ? 0xFFFF : work) }.pack();
+        s->data = data;
+        s->check = key ^ data;
+    }
+};
+
+static PnTable table;
+static int max_stones = 4;
+static uint64_t node_limit = 200000;
+
+static uint32_t pn_add(uint32_t a, uint32_t b) { return (a + b >= PN_INF) ? PN_INF - 1 : a + b; }
+
+struct PnSolver {
+    Position pos;
+    int attacker = PLAYER_X;
+    uint64_t nodes = 0, limit = 0;
+
+    // Search from pos with `player` to move; *move gets the first move of a win. True if the side to move wins.
+    int solve(int player, int att, int* move) {
+        attacker = att;
+        limit = nodes + node_limit;
+        uint32_t phi, delta;
+        mid(player, PN_INF - 1, PN_INF - 1, &phi, &delta, move);
+        return (phi == 0) ? 1 : (delta == 0) ? -1 : 0; // 1 proven, -1 disproven, 0 unknown
+    }
+
+private:
+    uint64_t key(int player, uint64_t stones_key) const {
+        uint64_t k = stones_key ^ ((player == PLAYER_X) ? ZOBRIST.side : 0);
+        return (attacker == PLAYER_O) ? k ^ PN_ATTACKER_O : k;
+    }
+    uint64_t key(int player) const { return key(player, pos.key); }
+
+    // Child after `player` plays sq, looked up without making the move; unseen positions start at (1, 1)
+    void lookup(int player, int sq, uint32_t* phi, uint32_t* delta) const {
+        PnEntry e;
+        if (table.probe(key(player ^ 1, pos.key ^ ZOBRIST.stone[player][sq]), e)) {
+            *phi = e.phi;
+            *delta = e.delta;
+        } else {
+            *phi = 1;
+            *delta = 1;
+        }
+    }
+
+    // Decided without moving: 1 side to move wins, -1 it does not, 0 search on. *moves gets the moves to try.
+    int gen(int player, Bitboard* moves, int* win) const {
+        int opp = player ^ 1;
+        Bitboard empty = pos.empty();
+        Bitboard own_fives = bb_five_cells(pos.stones[player], empty);
+        if (bb_any(own_fives)) {
+            *win = bb_pop_lsb(own_fives);
+            return 1;
+        }
+        if (!bb_any(empty)) return (player == attacker) ? -1 : 1; // Draw: the defender has held
+
+        Bitboard opp_fives = bb_five_cells(pos.stones[opp], empty);
+        int threats = bb_popcount(opp_fives);
+        if (threats > 1) return -1;
+        if (threats == 1) {
+            *moves = opp_fives;
+            return 0;
+        }
+
+        if (player == attacker) {
+            *moves = pos.candidates(1);
+            if (!bb_any(*moves)) *moves = empty; // Empty board
+            return 0;
+        }
+        Bitboard defences;
+        if (bb_three_defences(pos.stones[opp], empty, defences)) {
+            *moves = (defences | bb_four_cells(pos.stones[player], empty)) & empty;
+        } else {
+            *moves = empty;
+        }
+        return 0;
+    }
+
+    void mid(int player, uint32_t th_phi, uint32_t th_delta, uint32_t* out_phi, uint32_t* out_delta, int* best) {
+        nodes++;
+        Bitboard moves = { 0, 0 };
+        int win = -1;
+        int r = gen(player, &moves, &win);
+        if (r != 0) {
+            *out_phi = (r > 0) ? 0 : PN_INF;
+            *out_delta = (r > 0) ? PN_INF : 0;
+            if (best) *best = win;
+            table.store(key(player), *out_phi, *out_delta, 1);
+            return;
+        }
+
+        int sq[BB_CELLS];
+        int n = 0;
+        while (bb_any(moves)) sq[n++] = bb_pop_lsb(moves);
+
+        uint64_t start = nodes;
+        uint32_t phi = 0, delta = 0;
+        int c1 = 0;
+        for (;;) {
+            // phi = smallest child delta, delta = sum of child phis
+            uint32_t delta2 = PN_INF;
+            phi = PN_INF;
+            delta = 0;
+            uint32_t c1_phi = 0;
+            for (int i = 0; i < n; i++) {
+                uint32_t cp, cd;
+                lookup(player, sq[i], &cp, &cd);
+                delta = (cp == PN_INF) ? PN_INF : (delta == PN_INF ? PN_INF : pn_add(delta, cp));
+                if (cd < phi) {
+                    delta2 = phi;
+                    phi = cd;
+                    c1 = i;
+                    c1_phi = cp;
+                } else if (cd < delta2) {
+                    delta2 = cd;
+                }
+            }
+            if (phi >= th_phi || delta >= th_delta || nodes >= limit) break;
+
+            uint32_t child_phi = (delta == PN_INF) ? th_delta : th_delta - delta + c1_phi;
+            uint32_t child_delta = (delta2 == PN_INF || delta2 + 1 > th_phi) ? th_phi : delta2 + 1;
+            uint32_t cp, cd;
+            pos.make_move(sq[c1], player);
+            mid(player ^ 1, child_phi, child_delta, &cp, &cd, nullptr);
+            pos.unmake_move(sq[c1], player);
+        }
+
+        if (best && phi == 0) *best = sq[c1];
+        *out_phi = phi;
+        *out_delta = delta;
+        table.store(key(player), phi, delta, nodes - start);
+    }
+};
+
+struct RootPosition {
+    Bitboard stones[2];
+    int player;
+    uint64_t key; // book_key
+    int sym;
+};
+
+static std::vector<RootPosition> roots;
+static std::map<uint64_t, size_t> root_index; // book_key -> roots[]
+static std::atomic<size_t> next_root(0);
+static std::map<uint64_t, uint8_t> solved; // book_key -> canonical move or BOOK_LOST
+static std::atomic<int> wins(0), losses(0);
+static std::atomic<uint64_t> total_nodes(0);
+
+// Every position reached with X first and each later stone next to the others, once per symmetry class
+static void enumerate(Position& pos, int player) {
+    if (pos.stone_count > 0) {
+        int sym;
+        uint64_t key = book_key(pos, player, &sym);
+        if (root_index.count(key)) return;
+        root_index[key] = roots.size();
+        roots.push_back({ { pos.stones[0], pos.stones[1] }, player, key, sym });
+    }
+    if (pos.stone_count >= max_stones) return;
+
+    Bitboard moves = pos.candidates(1);
+    if (pos.stone_count == 0) moves = pos.empty();
+    while (bb_any(moves)) {
+        int sq = bb_pop_lsb(moves);
+        pos.make_move(sq, player);
+        if (!bb_has_five(pos.stones[player])) enumerate(pos, player ^ 1);
+        pos.unmake_move(sq, player);
+    }
+}
+
+static std::vector<uint8_t> results; // Per root: TT_NO_MOVE unsolved, BOOK_LOST, or a canonical move
+
+static void worker(PnSolver* s) {
+    for (;;) {
+        size_t i = next_root.fetch_add(1);
+        if (i >= roots.size()) break;
+        const RootPosition& root = roots[i];
+
+        s->pos.clear();
+        for (int p = 0; p < 2; p++) {
+            Bitboard b = root.stones[p];
+            while (bb_any(b)) s->pos.make_move(bb_pop_lsb(b), p);
+        }
+
+        int move = -1;
+        if (s->solve(root.player, root.player, &move) == 1 && move >= 0) {
+            results[i] = (uint8_t)book_transform(move, root.sym);
+            wins++;
+        } else if (s->solve(root.player, root.player ^ 1, nullptr) == -1) {
+            results[i] = BOOK_LOST; // The opponent proved a win against every move
+            losses++;
+        }
+    }
+    total_nodes += s->nodes;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) max_stones = atoi(argv[1]);
+    if (argc > 2) node_limit = strtoull(argv[2], nullptr, 10);
+    int threads = (argc > 3) ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    const char* out = (argc > 4) ? argv[4] : "book/caro_solved.bin";
+    if (threads < 1) threads = 1;
+
+    if (!table.init(PN_TABLE_BITS)) {
+        printf("Proof table alloc failed\n");
+        return 1;
+    }
+
+    Position pos;
+    pos.clear();
+    enumerate(pos, PLAYER_X);
+    results.assign(roots.size(), TT_NO_MOVE);
+    printf("%zu positions up to %d stones, %llu nodes each, %d threads\n",
+           roots.size(), max_stones, (unsigned long long)node_limit, threads);
+
+    uint64_t t0 = caro_now_us();
+    std::vector<PnSolver> solvers(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker, &solvers[t]);
+    for (auto& t : pool) t.join();
+    double secs = (caro_now_us() - t0) / 1e6;
+
+    for (size_t i = 0; i < roots.size(); i++) {
+        if (results[i] != TT_NO_MOVE) solved[roots[i].key] = results[i];
+    }
+
+    FILE* f = fopen(out, "wb");
+    if (!f) {
+        printf("Cannot write %s\n", out);
+        return 1;
+    }
+    BookHeader h = { BOOK_MAGIC, (uint32_t)solved.size(), (uint32_t)max_stones, 0 };
+    fwrite(&h, sizeof(h), 1, f);
+    for (auto& e : solved) fwrite(&e.first, sizeof(uint64_t), 1, f);
+    for (auto& e : solved) fwrite(&e.second, 1, 1, f);
+    fclose(f);
+
+    printf("%d wins, %d losses -> %s\n", wins.load(), losses.load(), out);
+    printf("%.1f s, %llu nodes, %.0f nodes/s\n", secs, (unsigned long long)total_nodes.load(), total_nodes.load() / secs);
+    return 0;
+}
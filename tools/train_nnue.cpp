@@ -0,0 +1,394 @@
+/*
+    Trains the NNUE evaluator (include/caro_nnue.h), writes its weight blob
+    and benchmarks it against the pattern-table evaluation.
+
+    1. Self-play with the pattern-table search at a fixed depth from random
+       4-stone openings, as in tools/tune_eval.cpp. Every position with no
+       five threat on the board is kept with a target between 0 (X wins) and
+       1 (O wins): half the game's result, half sigmoid(K * search score).
+       Each position is also kept with the colours swapped.
+    2. The float net (same shape as NnueNet) is trained with Adam on the
+       squared error of sigmoid(output), on all threads, a tenth of the
+       positions held out. Weights are clipped to what quantizes safely:
+       |l1| <= 1 keeps acc within int16 for any board.
+    3. The net is quantized (l1 x NNUE_QA into int16, out x NNUE_QB into int8)
+       and written. Output units map to pattern-table score units through K,
+       so both evaluations speak the same scale to the search.
+    4. Benchmarks on the same positions and games: nodes per second of a
+       fixed-depth search with each evaluator, then matches at equal depth
+       (strength per node) and at equal time per move.
+
+    With games = 0 the blob in out_file is loaded and only benchmarked;
+    match_openings = 0 skips the matches.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O2 -mavx2 -pthread -I include tools/train_nnue.cpp -o train_nnue
+        ./train_nnue [games] [depth] [threads] [out_file] [match_openings] [ms_per_move]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "caro_search.h"
+#include "selfplay.h"
+
+#define TRAIN_TT_BITS      16
+#define TRAIN_RANDOM_PLIES 10      // Random moves only happen before this ply
+#define TRAIN_RANDOM_RATE  8       // 1 in this many of those moves is random
+#define TRAIN_K            0.00017 // sigmoid scale of pattern-table scores, as fitted by tools/tune_eval.cpp
+#define TRAIN_EPOCHS       30
+#define TRAIN_BATCH        256
+#define TRAIN_LR           0.002
+#define BENCH_POSITIONS    20
+
+struct Sample {
+    uint8_t count[NNUE_FEATURES]; // Live windows per feature
+    float target;                 // For O
+};
+
+// Float version of NnueNet: activations in [0, 1], output in logits
+struct FloatNet {
+    float l1[NNUE_FEATURES][NNUE_HIDDEN];
+    float b1[NNUE_HIDDEN];
+    float out[NNUE_HIDDEN];
+    float b2;
+};
+
+static int depth = 3;
+static int threads = 1;
+static std::atomic<int> next_game{0};
+static std::mutex samples_lock;
+static std::vector<Sample> samples;
+
+static Sample features(const Position& game) {
+    Sample out = {};
+    for (int d = 0; d < 4; d++) {
+        for (int i = 0; i < line_count(d); i++) {
+            unsigned x = game.lines[PLAYER_X][d][i], o = game.lines[PLAYER_O][d][i];
+            for (int s = 0; s + WIN_COUNT <= line_length(d, i); s++) {
+                int f = nnue_window_feature((x >> s) & 0x1F, (o >> s) & 0x1F);
+                if (f >= 0) out.count[f]++;
+            }
+        }
+    }
+    return out;
+}
+
+static bool quiet(const Position& game) {
+    Bitboard empty = game.empty();
+    return !bb_any(bb_five_cells(game.stones[PLAYER_X], empty)) && !bb_any(bb_five_cells(game.stones[PLAYER_O], empty));
+}
+
+static void play_games(int games) {
+    std::unique_ptr<Search> search(new Search());
+    TransTable tt;
+    if (tt.init(TRAIN_TT_BITS)) search->tt = &tt;
+    std::vector<Sample> local;
+    std::vector<float> scores; // sigmoid(K * search score) per sample, -1 = no search
+
+    for (int g; (g = next_game.fetch_add(1)) < games;) {
+        uint64_t rng = 0x9E3779B97F4A7C15ULL * (uint64_t)(g + 1);
+        Position game;
+        game.clear();
+        random_opening(game, rng, 4);
+        tt.clear();
+
+        size_t first = local.size();
+        int winner = play_out(game, [&](const Position& p, int turn) {
+            bool keep = quiet(p);
+            if (keep) local.push_back(features(p));
+
+            int sq;
+            float predicted = -1.0f;
+            if (p.stone_count < TRAIN_RANDOM_PLIES && next_random(rng) % TRAIN_RANDOM_RATE == 0) {
+                MoveList moves;
+                search->pos = p;
+                search->gen_moves(moves, 1, turn);
+                sq = moves.count ? moves.sq[next_random(rng) % moves.count] : -1;
+            } else {
+                SearchResult r = engine_think(*search, p, turn, { depth, 0, 0, 0, QUIESCE_NODE_LIMIT, false });
+                sq = result_square(r);
+                int score_o = (turn == PLAYER_O) ? r.score : -r.score;
+                predicted = (float)(1.0 / (1.0 + exp(-TRAIN_K * score_o)));
+            }
+            if (keep) scores.push_back(predicted);
+            return sq;
+        });
+
+        float result = (winner == PLAYER_O) ? 1.0f : (winner == PLAYER_X) ? 0.0f : 0.5f;
+        for (size_t i = first; i < local.size(); i++) {
+            local[i].target = (scores[i] < 0) ? result : 0.5f * result + 0.5f * scores[i];
+        }
+        if ((g + 1) % 100 == 0) fprintf(stderr, "%d games\n", g + 1);
+    }
+
+    std::lock_guard<std::mutex> hold(samples_lock);
+    for (const Sample& s : local) {
+        samples.push_back(s);
+        Sample swapped;
+        for (int f = 0; f < NNUE_FEATURES / 2; f++) {
+            swapped.count[f] = s.count[f + NNUE_FEATURES / 2];
+            swapped.count[f + NNUE_FEATURES / 2] = s.count[f];
+        }
+        swapped.target = 1.0f - s.target;
+        samples.push_back(swapped);
+    }
+}
+
+// Output logit; fills the pre-activations if a is given
+static float forward(const FloatNet& net, const Sample& s, float* a) {
+    float acc[NNUE_HIDDEN];
+    for (int j = 0; j < NNUE_HIDDEN; j++) acc[j] = net.b1[j];
+    for (int f = 0; f < NNUE_FEATURES; f++) {
+        if (!s.count[f]) continue;
+        for (int j = 0; j < NNUE_HIDDEN; j++) acc[j] += s.count[f] * net.l1[f][j];
+    }
+    float y = net.b2;
+    for (int j = 0; j < NNUE_HIDDEN; j++) {
+        y += net.out[j] * std::min(std::max(acc[j], 0.0f), 1.0f);
+        if (a) a[j] = acc[j];
+    }
+    return y;
+}
+
+static float sigmoid(float y) { return 1.0f / (1.0f + expf(-y)); }
+
+// Adds the loss gradient of samples[idx[begin, end)] to grad; returns the summed loss
+static double backward(const FloatNet& net, const std::vector<size_t>& idx, size_t begin, size_t end, FloatNet& grad) {
+    double loss = 0;
+    float a[NNUE_HIDDEN];
+    for (size_t k = begin; k < end; k++) {
+        const Sample& s = samples[idx[k]];
+        float p = sigmoid(forward(net, s, a));
+        float d = p - s.target;
+        loss += d * d;
+        float dy = 2.0f * d * p * (1.0f - p);
+        grad.b2 += dy;
+        for (int j = 0; j < NNUE_HIDDEN; j++) {
+            float h = std::min(std::max(a[j], 0.0f), 1.0f);
+            grad.out[j] += dy * h;
+            float da = (a[j] > 0.0f && a[j] < 1.0f) ? dy * net.out[j] : 0.0f;
+            if (da == 0.0f) continue;
+            grad.b1[j] += da;
+            for (int f = 0; f < NNUE_FEATURES; f++) {
+                if (s.count[f]) grad.l1[f][j] += da * s.count[f];
+            }
+        }
+    }
+    return loss;
+}
+
+static double held_out_loss(const FloatNet& net, const std::vector<size_t>& idx, size_t begin) {
+    double loss = 0;
+    for (size_t k = begin; k < idx.size(); k++) {
+        float d = sigmoid(forward(net, samples[idx[k]], nullptr)) - samples[idx[k]].target;
+        loss += d * d;
+    }
+    return loss / (double)(idx.size() - begin);
+}
+
+static void train(FloatNet& net) {
+    const int params = sizeof(FloatNet) / sizeof(float);
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    float* w = (float*)&net;
+    for (int i = 0; i < params; i++) w[i] = ((float)(next_random(rng) % 2001) / 1000.0f - 1.0f) * 0.1f;
+    for (int j = 0; j < NNUE_HIDDEN; j++) {
+        net.b1[j] = 0.2f;
+        net.out[j] = (j % 2) ? 0.5f : -0.5f;
+    }
+
+    // Shuffled once: the same games never straddle the split, the colour-swapped twins may
+    std::vector<size_t> idx(samples.size());
+    for (size_t i = 0; i < idx.size(); i++) idx[i] = i;
+    for (size_t i = idx.size() - 1; i > 0; i--) std::swap(idx[i], idx[next_random(rng) % (i + 1)]);
+    size_t train_n = idx.size() - idx.size() / 10;
+
+    std::vector<float> m(params, 0.0f), v(params, 0.0f);
+    std::vector<FloatNet> grads(threads);
+    int step = 0;
+    for (int epoch = 1; epoch <= TRAIN_EPOCHS; epoch++) {
+        for (size_t i = train_n - 1; i > 0; i--) std::swap(idx[i], idx[next_random(rng) % (i + 1)]);
+        double loss = 0;
+        for (size_t b = 0; b < train_n; b += TRAIN_BATCH) {
+            size_t e = std::min(train_n, b + TRAIN_BATCH), chunk = (e - b + threads - 1) / threads;
+            std::vector<double> losses(threads, 0.0);
+            std::vector<std::thread> pool;
+            for (int t = 0; t < threads; t++) {
+                grads[t] = FloatNet{};
+                pool.emplace_back([&, t] {
+                    size_t lo = std::min(e, b + t * chunk), hi = std::min(e, lo + chunk);
+                    losses[t] = backward(net, idx, lo, hi, grads[t]);
+                });
+            }
+            for (auto& t : pool) t.join();
+
+            step++;
+            float lr = (float)(TRAIN_LR * (epoch > TRAIN_EPOCHS * 2 / 3 ? 0.2 : 1.0));
+            for (int i = 0; i < params; i++) {
+                float g = 0;
+                for (int t = 0; t < threads; t++) g += ((float*)&grads[t])[i];
+                g /= (float)(e - b);
+                m[i] = 0.9f * m[i] + 0.1f * g;
+                v[i] = 0.999f * v[i] + 0.001f * g * g;
+                float mh = m[i] / (1.0f - powf(0.9f, (float)step)), vh = v[i] / (1.0f - powf(0.999f, (float)step));
+                w[i] -= lr * mh / (sqrtf(vh) + 1e-8f);
+            }
+            for (int f = 0; f < NNUE_FEATURES; f++)
+                for (int j = 0; j < NNUE_HIDDEN; j++) net.l1[f][j] = std::min(std::max(net.l1[f][j], -1.0f), 1.0f);
+            for (int j = 0; j < NNUE_HIDDEN; j++) {
+                net.b1[j] = std::min(std::max(net.b1[j], -1.0f), 1.0f);
+                net.out[j] = std::min(std::max(net.out[j], -127.0f / NNUE_QB), 127.0f / NNUE_QB);
+            }
+            for (int t = 0; t < threads; t++) loss += losses[t];
+        }
+        if (epoch % 5 == 0 || epoch == 1) {
+            printf("epoch %d: loss %.5f, held out %.5f\n", epoch, loss / train_n, held_out_loss(net, idx, train_n));
+        }
+    }
+}
+
+static bool write_blob(const FloatNet& net, const char* out) {
+    NnueHeader h = { NNUE_MAGIC, NNUE_FEATURES, NNUE_HIDDEN, 0, 0 };
+    h.out_bias = (int32_t)lround(net.b2 * NNUE_QA * NNUE_QB);
+    h.out_mul = (int32_t)lround(65536.0 / (TRAIN_K * NNUE_QA * NNUE_QB));
+    int16_t b1[NNUE_HIDDEN], l1[NNUE_FEATURES][NNUE_HIDDEN];
+    int8_t w2[NNUE_HIDDEN];
+    for (int j = 0; j < NNUE_HIDDEN; j++) {
+        b1[j] = (int16_t)lround(net.b1[j] * NNUE_QA);
+        w2[j] = (int8_t)lround(net.out[j] * NNUE_QB);
+        for (int f = 0; f < NNUE_FEATURES; f++) l1[f][j] = (int16_t)lround(net.l1[f][j] * NNUE_QA);
+    }
+
+    FILE* f = fopen(out, "wb");
+    if (!f) return false;
+    fwrite(&h, sizeof(h), 1, f);
+    fwrite(b1, sizeof(b1), 1, f);
+    fwrite(l1, sizeof(l1), 1, f);
+    fwrite(w2, sizeof(w2), 1, f);
+    fclose(f);
+    return true;
+}
+
+// Positions 4 random stones plus 6 depth-2 moves into a game
+static void bench_positions(std::vector<Position>& out) {
+    std::unique_ptr<Search> search(new Search());
+    for (int i = 0; i < BENCH_POSITIONS; i++) {
+        uint64_t rng = 0x6A09E667F3BCC909ULL * (uint64_t)(i + 1);
+        Position game;
+        game.clear();
+        random_opening(game, rng, 4);
+        for (int ply = 0, turn = PLAYER_X; ply < 6; ply++, turn ^= 1) {
+            SearchResult r = engine_think(*search, game, turn, { 2, 0, 0, 0, 0, false });
+            if (r.move.r < 0) break;
+            game.make_move(bb_square(r.move.r, r.move.c), turn);
+        }
+        out.push_back(game);
+    }
+}
+
+static void bench_speed(const NnueNet* net, const std::vector<Position>& positions, int d) {
+    std::unique_ptr<Search> search(new Search());
+    TransTable tt;
+    if (tt.init(20)) search->tt = &tt;
+    uint64_t nodes = 0, t0 = caro_now_us();
+    for (const Position& p : positions) {
+        tt.clear();
+        nodes += engine_think(*search, p, PLAYER_X, { d, 0, 0, 0, QUIESCE_NODE_LIMIT, false }, nullptr, net).stats.nodes;
+    }
+    double secs = (caro_now_us() - t0) / 1e6;
+    printf("%-13s depth %d: %llu nodes, %.2f s, %.0f nodes/s\n", net ? "NNUE" : "pattern table", d,
+           (unsigned long long)nodes, secs, nodes / secs);
+}
+
+// NNUE (a) against the pattern table (b), each opening with both colours; limits apply to both
+static void match(const NnueNet* net, int openings, const SearchLimits& limits, const char* what) {
+    std::atomic<int> next{0};
+    std::mutex lock;
+    GameTally score = { 0, 0, 0 }; // For NNUE
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&] {
+            std::unique_ptr<Search> search[2] = { std::unique_ptr<Search>(new Search()), std::unique_ptr<Search>(new Search()) };
+            TransTable tt[2];
+            for (int i = 0; i < 2; i++) {
+                if (tt[i].init(TRAIN_TT_BITS)) search[i]->tt = &tt[i];
+            }
+            for (int g; (g = next.fetch_add(1)) < openings * 2;) {
+                uint64_t rng = 0xD1B54A32D192ED03ULL * (uint64_t)(g / 2 + 1);
+                Position game;
+                game.clear();
+                random_opening(game, rng, 4);
+                tt[0].clear();
+                tt[1].clear();
+
+                int nnue_side = g % 2;
+                int winner = play_out(game, [&](const Position& p, int turn) {
+                    bool a = turn == nnue_side;
+                    return result_square(engine_think(*search[a ? 0 : 1], p, turn, limits, nullptr, a ? net : nullptr));
+                });
+                std::lock_guard<std::mutex> hold(lock);
+                score.add(winner, nnue_side);
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    printf("NNUE vs pattern table, %s: %d wins, %d losses, %d draws (%.1f%%)\n",
+           what, score.wins, score.losses, score.draws, 100.0 * score.points() / (openings * 2));
+}
+
+int main(int argc, char** argv) {
+    int games = (argc > 1) ? atoi(argv[1]) : 2000;
+    if (argc > 2) depth = atoi(argv[2]);
+    threads = (argc > 3) ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    const char* out = (argc > 4) ? argv[4] : "book/caro_nnue.bin";
+    int openings = (argc > 5) ? atoi(argv[5]) : 100;
+    uint32_t ms = (argc > 6) ? (uint32_t)atoi(argv[6]) : 100;
+    if (threads < 1) threads = 1;
+
+    if (games > 0) {
+        printf("%d self-play games at depth %d, %d threads\n", games, depth, threads);
+        uint64_t t0 = caro_now_us();
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++) pool.emplace_back(play_games, games);
+        for (auto& t : pool) t.join();
+        printf("%zu positions with colour swaps, %.1f s\n", samples.size(), (caro_now_us() - t0) / 1e6);
+        if (samples.size() < 1000) {
+            printf("Too few positions, play more games\n");
+            return 1;
+        }
+
+        static FloatNet net;
+        train(net);
+        if (!write_blob(net, out)) {
+            printf("Cannot write %s\n", out);
+            return 1;
+        }
+        printf("-> %s\n", out);
+    }
+
+    size_t size = 0;
+    const void* blob = caro_map_readonly(out, &size);
+    static NnueNet net;
+    if (!net.load(blob, size)) {
+        printf("No valid net in %s\n", out);
+        return 1;
+    }
+
+    std::vector<Position> positions;
+    bench_positions(positions);
+    for (int d = 4; d <= 6; d += 2) {
+        bench_speed(nullptr, positions, d);
+        bench_speed(&net, positions, d);
+    }
+    if (openings <= 0) return 0;
+    char what[32];
+    snprintf(what, sizeof(what), "depth %d", depth);
+    match(&net, openings, { depth, 0, 0, 0, QUIESCE_NODE_LIMIT, false }, what);
+    snprintf(what, sizeof(what), "%u ms/move", ms);
+    match(&net, openings, { 10, ms, 0, 0, QUIESCE_NODE_LIMIT, false }, what);
+    return 0;
+}
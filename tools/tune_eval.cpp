@@ -0,0 +1,277 @@
+/*
+    Tunes the evaluation weights (include/caro_weights.h) Texel-style and
+    writes them back as a header.
+
+    1. Self-play: every thread plays games between two fixed-depth searches
+       from random 4-stone openings, with an occasional random move early on
+       for variety. Each position reached with no five threat on the board is
+       kept with the game's result (1 O won, 0.5 draw, 0 X won).
+    2. The evaluation is linear in the weights, so each position is reduced
+       once to its shape counts (O's minus X's per SegmentShape), found by
+       scoring it with one unit weight at a time.
+    3. K of the prediction sigmoid(K * eval) is fitted to the current weights;
+       then each weight is scaled up and down by a shrinking factor as long as
+       the mean squared error between result and prediction drops. A tenth of
+       the positions is held out to show whether the fit generalises.
+    4. The tuned weights play the current ones at the same depth, i.e. for the
+       same nodes on the device, and the header is written either way; the
+       match result is in its comment so a worse table is easy to spot.
+
+    Build and run from the repository root:
+        g++ -std=gnu++17 -O2 -pthread -I include tools/tune_eval.cpp -o tune_eval
+        ./tune_eval [games] [depth] [threads] [out_file] [match_openings]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "caro_search.h"
+#include "selfplay.h"
+
+#define TUNE_TT_BITS      16
+#define TUNE_RANDOM_PLIES 10             // Random moves only happen before this ply
+#define TUNE_RANDOM_RATE  8              // 1 in this many of those moves is random
+#define TUNE_MAX_WEIGHT   (SCORE_WIN / 20) // Keeps sums of shapes well below the win score
+
+struct Sample {
+    int16_t f[EVAL_WEIGHT_COUNT]; // O's minus X's count of each shape
+    float result;                 // For O
+};
+
+static int depth = 2;
+static int threads = 1;
+static std::atomic<int> next_game{0};
+static std::mutex samples_lock;
+static std::vector<Sample> samples;
+
+static int engine_move(Search& search, const Position& game, int side, const EvalWeights* w) {
+    return result_square(engine_think(search, game, side, { depth, 0, 0, 0, QUIESCE_NODE_LIMIT, false }, w));
+}
+
+// Shape counts of the stones in game, O's minus X's
+static Sample features(const Position& game) {
+    struct UnitWeights {
+        EvalWeights w[EVAL_WEIGHT_COUNT];
+        UnitWeights() {
+            for (int s = 0; s < EVAL_WEIGHT_COUNT; s++) {
+                for (int k = 0; k < SHAPE_COUNT; k++) w[s].shape[k] = (k == s);
+            }
+        }
+    };
+    static const UnitWeights unit;
+    Sample out = {};
+    Position p = game;
+    for (int s = 1; s < EVAL_WEIGHT_COUNT; s++) {
+        p.set_weights(&unit.w[s]);
+        out.f[s] = (int16_t)p.score;
+    }
+    return out;
+}
+
+static void play_games(int games) {
+    std::unique_ptr<Search> search(new Search());
+    TransTable tt;
+    if (tt.init(TUNE_TT_BITS)) search->tt = &tt;
+    std::vector<Sample> local;
+
+    for (int g; (g = next_game.fetch_add(1)) < games;) {
+        uint64_t rng = 0x9E3779B97F4A7C15ULL * (uint64_t)(g + 1);
+        Position game;
+        game.clear();
+        random_opening(game, rng, 4);
+        tt.clear();
+
+        size_t first = local.size();
+        int winner = play_out(game, [&](const Position& p, int turn) {
+            Bitboard empty = p.empty();
+            if (!bb_any(bb_five_cells(p.stones[PLAYER_X], empty)) && !bb_any(bb_five_cells(p.stones[PLAYER_O], empty))) {
+                local.push_back(features(p));
+            }
+            if (p.stone_count < TUNE_RANDOM_PLIES && next_random(rng) % TUNE_RANDOM_RATE == 0) {
+                MoveList moves;
+                search->pos = p;
+                search->gen_moves(moves, 1, turn);
+                return moves.count ? (int)moves.sq[next_random(rng) % moves.count] : -1;
+            }
+            return engine_move(*search, p, turn, &DEFAULT_WEIGHTS);
+        });
+
+        float result = (winner == PLAYER_O) ? 1.0f : (winner == PLAYER_X) ? 0.0f : 0.5f;
+        for (size_t i = first; i < local.size(); i++) local[i].result = result;
+        if ((g + 1) % 100 == 0) fprintf(stderr, "%d games\n", g + 1);
+    }
+
+    std::lock_guard<std::mutex> hold(samples_lock);
+    samples.insert(samples.end(), local.begin(), local.end());
+}
+
+// Mean squared error of sigmoid(k * eval) over samples[begin, end), summed on all threads
+static double error(const double* w, double k, size_t begin, size_t end) {
+    std::vector<double> sums(threads, 0.0);
+    std::vector<std::thread> pool;
+    size_t chunk = (end - begin + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            size_t lo = begin + t * chunk, hi = std::min(end, lo + chunk);
+            double sum = 0;
+            for (size_t i = lo; i < hi; i++) {
+                double eval = 0;
+                for (int s = 1; s < EVAL_WEIGHT_COUNT; s++) eval += w[s] * samples[i].f[s];
+                double d = samples[i].result - 1.0 / (1.0 + exp(-k * eval));
+                sum += d * d;
+            }
+            sums[t] = sum;
+        });
+    }
+    for (auto& t : pool) t.join();
+    double sum = 0;
+    for (double s : sums) sum += s;
+    return sum / (double)(end - begin);
+}
+
+// K minimising the error of the current weights, by ternary search on log K
+static double fit_k(const double* w, size_t n) {
+    double lo = log(1e-7), hi = log(1e-2);
+    for (int i = 0; i < 60; i++) {
+        double a = lo + (hi - lo) / 3, b = hi - (hi - lo) / 3;
+        if (error(w, exp(a), 0, n) < error(w, exp(b), 0, n)) hi = b; else lo = a;
+    }
+    return exp((lo + hi) / 2);
+}
+
+// Games between two weight tables at the same depth, each opening played with both colours.
+// Returns the score of `a` in games: wins + draws / 2.
+static double match(const EvalWeights* a, const EvalWeights* b, int openings, int& wins, int& losses, int& draws) {
+    std::atomic<int> next{0};
+    std::mutex lock;
+    GameTally score = { 0, 0, 0 }; // For a
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&] {
+            // One search and table per side: stored scores only mean something under their own weights
+            std::unique_ptr<Search> search[2] = { std::unique_ptr<Search>(new Search()), std::unique_ptr<Search>(new Search()) };
+            TransTable tt[2];
+            for (int i = 0; i < 2; i++) {
+                if (tt[i].init(TUNE_TT_BITS)) search[i]->tt = &tt[i];
+            }
+            for (int g; (g = next.fetch_add(1)) < openings * 2;) {
+                uint64_t rng = 0xD1B54A32D192ED03ULL * (uint64_t)(g / 2 + 1);
+                Position game;
+                game.clear();
+                random_opening(game, rng, 4);
+                tt[0].clear();
+                tt[1].clear();
+
+                int a_side = g % 2;
+                int winner = play_out(game, [&](const Position& p, int turn) {
+                    return (turn == a_side) ? engine_move(*search[0], p, turn, a) : engine_move(*search[1], p, turn, b);
+                });
+                std::lock_guard<std::mutex> hold(lock);
+                score.add(winner, a_side);
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    wins = score.wins, losses = score.losses, draws = score.draws;
+    return score.points();
+}
+
+int main(int argc, char** argv) {
+    int games = (argc > 1) ? atoi(argv[1]) : 2000;
+    if (argc > 2) depth = atoi(argv[2]);
+    threads = (argc > 3) ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    const char* out = (argc > 4) ? argv[4] : "include/caro_weights.h";
+    int openings = (argc > 5) ? atoi(argv[5]) : 100;
+    if (threads < 1) threads = 1;
+
+    printf("%d self-play games at depth %d, %d threads\n", games, depth, threads);
+    uint64_t t0 = caro_now_us();
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(play_games, games);
+    for (auto& t : pool) t.join();
+    if (samples.size() < 100) {
+        printf("Only %zu positions, play more games\n", samples.size());
+        return 1;
+    }
+
+    // Hold out every tenth position, after a shuffle so one game does not land on both sides
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+    for (size_t i = samples.size() - 1; i > 0; i--) std::swap(samples[i], samples[next_random(rng) % (i + 1)]);
+    size_t train = samples.size() - samples.size() / 10;
+    printf("%zu positions (%zu held out), %.1f s\n", samples.size(), samples.size() - train, (caro_now_us() - t0) / 1e6);
+
+    double w[EVAL_WEIGHT_COUNT];
+    for (int s = 0; s < EVAL_WEIGHT_COUNT; s++) w[s] = DEFAULT_WEIGHTS.shape[s];
+    double k = fit_k(w, train);
+    double start_train = error(w, k, 0, train), start_test = error(w, k, train, samples.size());
+    printf("K = %.3g, error %.5f (held out %.5f)\n", k, start_train, start_test);
+
+    double best = start_train;
+    static const double factors[] = { 1.5, 1.2, 1.1, 1.05, 1.02 };
+    for (double f : factors) {
+        for (bool improved = true; improved;) {
+            improved = false;
+            for (int s = 1; s < EVAL_WEIGHT_COUNT; s++) {
+                for (double m : { f, 1.0 / f }) {
+                    double old = w[s];
+                    w[s] = std::min(std::max(round(old * m), 1.0), (double)TUNE_MAX_WEIGHT);
+                    double e = (w[s] != old) ? error(w, k, 0, train) : best;
+                    if (e < best) {
+                        best = e;
+                        improved = true;
+                        break;
+                    }
+                    w[s] = old;
+                }
+            }
+        }
+        printf("step %.2f: error %.5f, weights", f, best);
+        for (int s = 1; s < EVAL_WEIGHT_COUNT; s++) printf(" %.0f", w[s]);
+        printf("\n");
+    }
+    double end_test = error(w, k, train, samples.size());
+    printf("held out error %.5f -> %.5f\n", start_test, end_test);
+
+    EvalWeights tuned = DEFAULT_WEIGHTS;
+    for (int s = 1; s < EVAL_WEIGHT_COUNT; s++) tuned.shape[s] = (int32_t)w[s];
+    int wins = 0, losses = 0, draws = 0;
+    double points = match(&tuned, &DEFAULT_WEIGHTS, openings, wins, losses, draws);
+    printf("tuned vs current at depth %d: %d wins, %d losses, %d draws (%.1f%%)\n",
+           depth, wins, losses, draws, 100.0 * points / (openings * 2));
+
+    FILE* f = fopen(out, "w");
+    if (!f) {
+        printf("Cannot write %s\n", out);
+        return 1;
+    }
+    static const char* names[EVAL_WEIGHT_COUNT] = { "none", "open two", "blocked three", "open three", "blocked four", "open four" };
+    fprintf(f, "/*\n"
+               "    Evaluation weights, indexed by SegmentShape (caro_position.h) from\n"
+               "    SHAPE_NONE to SHAPE_OPEN_4. A five is not tuned: it always scores SCORE_WIN.\n"
+               "\n"
+               "    Written by tools/tune_eval.cpp from %d self-play games at depth %d:\n"
+               "    %zu positions, K = %.3g, held-out error %.5f -> %.5f. Against the\n"
+               "    previous weights at the same depth: %d wins, %d losses, %d draws.\n"
+               "*/\n"
+               "#pragma once\n"
+               "\n"
+               "#include <stdint.h>\n"
+               "\n"
+               "#define EVAL_WEIGHT_COUNT %d\n"
+               "\n"
+               "static constexpr int32_t EVAL_WEIGHTS[EVAL_WEIGHT_COUNT] = {\n",
+            games, depth, samples.size(), k, start_test, end_test, wins, losses, draws, EVAL_WEIGHT_COUNT);
+    for (int s = 0; s < EVAL_WEIGHT_COUNT; s++) {
+        char num[16];
+        snprintf(num, sizeof(num), "%d,", (int)tuned.shape[s]);
+        fprintf(f, "    %-7s// %s\n", num, names[s]);
+    }
+    fprintf(f, "};\n");
+    fclose(f);
+    printf("-> %s\n", out);
+    return 0;
+}